@@ -1,9 +1,44 @@
  #include "src/WifiConnection.h"
  #include "src/FirebaseDb.h"
  #include "src/Application.h"
+ #include "src/DetectionQueue.h"
+ #include "src/TimeService.h"
+ #include "src/Scheduler.h"
+ #include "src/Metrics.h"
 
  #define MOTOR_RELAY_OUTPUT 14
 
+ /* Real-time sensing runs on the application core, WiFi/TLS work on the protocol core */
+ #define SENSOR_TASK_CORE 1
+ #define NETWORK_TASK_CORE 0
+ #define SENSOR_TASK_STACK 4096
+ #define NETWORK_TASK_STACK 8192
+
+ /* Job periods in milliseconds and time budgets in microseconds */
+ #define APP_JOB_PERIOD 2 // First run only, then App_getNextRunDelay()
+ #define APP_JOB_BUDGET 2000
+ #define WIFI_JOB_PERIOD 100
+ #define WIFI_JOB_BUDGET 10000
+ #define TIME_JOB_PERIOD 1000
+ #define TIME_JOB_BUDGET 1000
+ #define HANDOVER_JOB_PERIOD 100
+ #define HANDOVER_JOB_BUDGET 20000
+ #define DATABASE_JOB_PERIOD 10
+ #define DATABASE_JOB_BUDGET 1000000
+ #define STATS_JOB_PERIOD 600000
+ #define STATS_JOB_BUDGET 10000
+ #define CONSOLE_JOB_PERIOD 100
+ #define CONSOLE_JOB_BUDGET 10000
+
+/* Detection records handed over from sensor task (producer) to network task (consumer) */
+static t_DetectionQueue detectionQueue;
+
+/* Jobs of sensor task (core 1) and network task (core 0) */
+static t_Scheduler sensorScheduler;
+static t_Scheduler networkScheduler;
+static int8_t appJobId = -1;
+static int8_t handoverJobId = -1;
+
 void setMotor(bool state)
 {
   static bool motor_state = false;
@@ -16,16 +51,16 @@ void setMotor(bool state)
 void Wifi_failureHandler(void)
 {
   Serial.println("Wifi failure handled");
-  setMotor(false); // Shutdown motor
-  Database_refreshConnection();
+  Database_refreshConnection(); // Detections are journaled on flash until connection is back
 }
 
-void App_objectDetectionHandler(t_Color * color)
+void App_objectDetectionHandler(t_ObjectRecord * object)
 {
-  if (Database_pushObjectColor(color))
-    Serial.println("Push OK");
-  else 
-    Serial.println("Push failed");
+  /* Never wait for the network here, this runs in the sensor task */
+  if (!DetectionQueue_push(&detectionQueue, object))
+    Serial.println("Detection queue full");
+
+  Scheduler_signal(&networkScheduler, handoverJobId);
 }
 
 void App_objectOverheightHandler(void)
@@ -34,43 +69,166 @@ void App_objectOverheightHandler(void)
   setMotor(false); // Shutdown motor
 }
 
-void setup()
+static bool networkReady(void)
 {
-  Serial.begin(115200);
+  return ((Wifi_getState() == WIFI_CONNECTED) && (Database_getState() == FIREBASE_CONNECTED));
+}
 
-  pinMode(MOTOR_RELAY_OUTPUT, OUTPUT);
-  digitalWrite(MOTOR_RELAY_OUTPUT, LOW);
-  
-  App_init();
-  App_setObjectDetectionCallback(App_objectDetectionHandler);
-  App_setObjectOverheightCallback(App_objectOverheightHandler);
-  App_setMotorCallback(setMotor);
-  
-  Wifi_init();
-  Wifi_setFailureCallback(Wifi_failureHandler);
+/* First connection gives the wall-clock time records are stamped with,
+ * afterwards network outages are covered by the flash journal.
+ * Only the belt waits for it, sensors validate or calibrate from boot
+ */
+static bool startupComplete(void)
+{
+  static bool complete = false;
+  if (!complete) complete = (networkReady() && TimeService_isSynced());
+  return complete;
 }
 
-void loop()
+/* Motor switched by the application (color capture), held off until startup completes */
+static void App_motorHandler(bool state)
+{
+  setMotor(state && startupComplete());
+}
+
+/* Sensor task jobs */
+static void appJob(void)
+{
+  // Application task (calibration, then object detection)
+  METRICS_START(appStart);
+  App_task();
+  METRICS_STOP(METRICS_APP_TASK, appStart);
+
+  // Run motor once startup is complete, if overheight is not detected and no color capture is pending
+  setMotor(startupComplete() && App_getMotorCondition());
+
+  // Sleep until the next sample or timeout of the application, sensor events wake it up sooner
+  Scheduler_setNextRun(&sensorScheduler, appJobId, App_getNextRunDelay());
+}
+
+/* Network task jobs */
+static void wifiJob(void)
 {
   // Constantly monitor wifi connection
   Wifi_task();
+}
 
-  // Monitor connection to Firebase database
-  if (Wifi_getState() == WIFI_CONNECTED)
+static void timeJob(void)
+{
+  // Take SNTP updates as new time anchor
+  TimeService_task();
+}
+
+static void handoverJob(void)
+{
+  // Records are stamped with wall-clock time, wait for the first synchronization
+  if (!TimeService_isSynced()) return;
+
+  // Hand detections over to the upload queue (or flash journal while offline)
+  t_ObjectRecord object;
+  while (DetectionQueue_pop(&detectionQueue, &object))
   {
-    Database_task();
+    if (!Database_enqueueObject(&object))
+      Serial.println("Detection record dropped");
   }
+}
+
+static void databaseJob(void)
+{
+  if (Wifi_getState() != WIFI_CONNECTED) return;
+
+  // Monitor connection to Firebase database, push queued records
+  METRICS_START(databaseStart);
+  Database_task();
+  METRICS_STOP(METRICS_DATABASE_TASK, databaseStart);
+}
+
+static void schedulerStatsJob(void)
+{
+  Scheduler_printStats(&sensorScheduler, "sensor");
+  Scheduler_printStats(&networkScheduler, "network");
+#if METRICS_ENABLE
+  Metrics_print();
+#endif
+}
+
+/* Serial commands: 'm' prints stage latencies */
+static void consoleJob(void)
+{
+  while (Serial.available() > 0)
+  {
+    char command = (char)Serial.read();
+#if METRICS_ENABLE
+    if (command == 'm') Metrics_print();
+#else
+    (void)command;
+#endif
+  }
+}
+
+/* Sensor interrupt or proximity data: run the application at once */
+static void IRAM_ATTR App_wakeHandler(bool fromIsr)
+{
+  if (fromIsr)
+    Scheduler_signalFromIsr(&sensorScheduler, appJobId);
   else
+    Scheduler_signal(&sensorScheduler, appJobId);
+}
+
+void sensorTask(void * parameter)
+{
+  for (;;)
   {
-    delay(200);
-    return;
+    Scheduler_run(&sensorScheduler);
   }
+}
 
-  // Application task (object detection)
-  if (Database_getState() == FIREBASE_CONNECTED)
+void networkTask(void * parameter)
+{
+  for (;;)
   {
-    App_task();
- 
-    setMotor(!App_getOverheightCondition()); // Run motor if overheight is not detected
+    Scheduler_run(&networkScheduler);
   }
 }
+
+void setup()
+{
+  Serial.begin(115200);
+
+  pinMode(MOTOR_RELAY_OUTPUT, OUTPUT);
+  digitalWrite(MOTOR_RELAY_OUTPUT, LOW);
+
+  DetectionQueue_init(&detectionQueue);
+#if METRICS_ENABLE
+  Metrics_init();
+#endif
+
+  App_init();
+  App_setObjectDetectionCallback(App_objectDetectionHandler);
+  App_setObjectOverheightCallback(App_objectOverheightHandler);
+  App_setMotorCallback(App_motorHandler);
+  
+  Wifi_init();
+  Wifi_setFailureCallback(Wifi_failureHandler);
+
+  Scheduler_init(&sensorScheduler);
+  appJobId = Scheduler_add(&sensorScheduler, "app", appJob, APP_JOB_PERIOD, APP_JOB_BUDGET);
+  App_setWakeCallback(App_wakeHandler);
+
+  Scheduler_init(&networkScheduler);
+  Scheduler_add(&networkScheduler, "wifi", wifiJob, WIFI_JOB_PERIOD, WIFI_JOB_BUDGET);
+  Scheduler_add(&networkScheduler, "time", timeJob, TIME_JOB_PERIOD, TIME_JOB_BUDGET);
+  handoverJobId = Scheduler_add(&networkScheduler, "handover", handoverJob, HANDOVER_JOB_PERIOD, HANDOVER_JOB_BUDGET);
+  Scheduler_add(&networkScheduler, "database", databaseJob, DATABASE_JOB_PERIOD, DATABASE_JOB_BUDGET);
+  Scheduler_add(&networkScheduler, "stats", schedulerStatsJob, STATS_JOB_PERIOD, STATS_JOB_BUDGET);
+  Scheduler_add(&networkScheduler, "console", consoleJob, CONSOLE_JOB_PERIOD, CONSOLE_JOB_BUDGET);
+
+  xTaskCreatePinnedToCore(networkTask, "network", NETWORK_TASK_STACK, nullptr, 1, nullptr, NETWORK_TASK_CORE);
+  xTaskCreatePinnedToCore(sensorTask, "sensor", SENSOR_TASK_STACK, nullptr, 2, nullptr, SENSOR_TASK_CORE);
+}
+
+void loop()
+{
+  // All work is done by sensor and network tasks
+  vTaskDelete(NULL);
+}
@@ -5,31 +5,273 @@
 #include "Lib/US-100/PingSerial.h"
 
 #include "Application.h"
+#include "ColorClassifier.h"
+#include "CalibrationStore.h"
+#include "SampleHistory.h"
+#include "PresenceDetector.h"
 #include "Calib.h"
 
+/* Open-drain INT output of color sensor, active low */
+#define COLOR_SENSOR_INT_PIN 4
+
+/* Color sensor settings used while waiting for objects */
+#define COLOR_PREVIEW_INTEGRATION_TIME TCS34725_INTEGRATIONTIME_24MS
+#define COLOR_PREVIEW_GAIN TCS34725_GAIN_4X
+
+/* Run period of App_task() while the profile is validated or sensors calibrated, milliseconds */
+#define APP_CALIBRATION_PERIOD 2
+
+/* PingSerial sends a distance request again once the reply is 99 ms late,
+ * only replies wake the application up */
+#define PROXIMITY_SENSOR_TIMEOUT 100
+
+/* Version of saved calibration profile layout, part of the fingerprint */
+#define CALIB_PROFILE_VERSION 1
+
 /* Sensor objects */
-static Adafruit_TCS34725 colorSensor = Adafruit_TCS34725(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_4X);
+static Adafruit_TCS34725 colorSensor = Adafruit_TCS34725(COLOR_PREVIEW_INTEGRATION_TIME, COLOR_PREVIEW_GAIN);
 static PingSerial proximitySensor = PingSerial(Serial2, MINIMUM_DISTANCE, MAXIMUM_DISTANCE); /* Proximity sensor connected to ESP32 UART2 (GPIO16/17) */
 
 /* Application static variables */
 static t_AppState App_state = APP_INIT;
 static bool App_overheightCondition = true; /* Initialize to true to avoid motor spurious start */
 static t_Color App_colorSensorBaseline = {0, 0, 0, 0};
+static uint16_t App_colorSensorClearBaseline = 0;
+static volatile bool App_colorSensorInterrupt = false;
+static uint16_t App_colorSensorLastClear = 0; /* Scaled to preview exposure */
+static uint8_t App_colorSensorIntegrationTime = COLOR_PREVIEW_INTEGRATION_TIME; /* Exposure of the running conversion */
+static tcs34725Gain_t App_colorSensorGain = COLOR_PREVIEW_GAIN;
 static uint16_t App_proximitySensorBaseline = 0;
+
+/* Baselines tracked in Q8 fixed point (red, green, blue, clear), calibrated values they may drift from */
+static uint32_t App_colorBaselineTrack[4] = {0, 0, 0, 0};
+static uint32_t App_proximityBaselineTrack = 0;
+static t_Color App_colorCalibratedBaseline = {0, 0, 0, 0};
+static uint16_t App_colorCalibratedClear = 0;
+static uint16_t App_proximityCalibratedBaseline = 0;
+static uint16_t App_colorInterruptClear = 0; /* Clear level the interrupt window is centered on */
+static uint32_t App_colorSensorLastReading = 0;
+static bool App_colorSensorIdle = true; /* No object expected or captured, readings on INT or baseline period only */
+static uint8_t App_baselineFlags = 0;
+
+/* Recent readings of the empty-belt decision channels */
+static t_SampleHistory App_distanceHistory;
+static t_SampleHistory App_colorHistory[3]; /* red, green, blue */
+
+/* Object presence under each sensor */
+static t_PresenceDetector App_distancePresence;
+static t_PresenceDetector App_colorPresence;
+
+/* Saved calibration profile */
+static t_CalibrationProfile App_profile;
+static uint32_t App_profileSaveTime = 0;
+static t_AppStartupReport App_startupReport = {false, 0, 0};
 static t_appObjectDetectionCallback App_objectDetectionCallback = nullptr;
 static t_appObjectOverheightCallback App_objectOverheightCallback = nullptr;
 static t_appMotorCallback App_motorCallback = nullptr;
+static t_appWakeCallback App_wakeCallback = nullptr;
+static bool App_colorCaptureInProgress = false;
+static t_AppCaptureMode App_captureMode = APP_CAPTURE_STOP_AND_READ;
+static t_AppCaptureMode App_activeCaptureMode = APP_CAPTURE_STOP_AND_READ; /* Mode latched for the object being captured */
+static t_Color App_flyingSamples[COLOR_FLYING_CAPTURE_SAMPLES];
+static uint8_t App_flyingSampleCount = 0;
 
 /* Coupling between state machine
- * of proximity and color sensor
+ * of proximity and color sensor:
+ * objects detected by distance wait here (oldest first)
+ * until the color stage captures them
  */
-typedef enum {
-    OBJECT_NOT_DETECTED = 0,
-    OBJECT_DETECTED_BY_DISTANCE,
-    OBJECT_DETECTED_BY_COLOR
-} t_objectDetectionState;
+static t_ObjectRecord App_trackedObjects[OBJECT_TRACKING_CAPACITY];
+static uint32_t App_trackedStoppedTime[OBJECT_TRACKING_CAPACITY]; /* App_beltStoppedTime() when each object arrived */
+static uint8_t App_trackedObjectsHead = 0;
+static uint8_t App_trackedObjectsCount = 0;
+static uint32_t App_objectSequence = 0;
+
+/* Conveyor motion estimate */
+static t_BeltEstimate App_beltEstimate = {0, 0, 0};
+static bool App_beltStopped = true; /* Motor condition off: overheight or stop-and-read capture */
+static uint32_t App_beltStopTime = 0;   /* millis() of the last stop */
+static uint32_t App_beltStoppedTotal = 0; /* Milliseconds of completed stops since boot */
+
+/* Follow the motor condition, so timings of objects in flight
+ * can be shifted by the time the belt stood still
+ */
+static void App_updateBeltMotion(void)
+{
+    bool stopped = !App_getMotorCondition();
+    if (stopped == App_beltStopped)
+        return;
 
-static t_objectDetectionState App_detectionState = OBJECT_NOT_DETECTED;
+    if (stopped)
+        App_beltStopTime = millis();
+    else
+        App_beltStoppedTotal += millis() - App_beltStopTime;
+
+    App_beltStopped = stopped;
+}
+
+/* Milliseconds the belt stood still since boot, running stop included */
+static uint32_t App_beltStoppedTime(void)
+{
+    return App_beltStoppedTotal + (App_beltStopped ? (millis() - App_beltStopTime) : 0);
+}
+
+/* Time the belt stood still since a tracked object reached the proximity sensor
+ *
+ * input: object - record of a tracked object
+ * output: milliseconds stopped, 0 if the belt kept running
+ */
+static uint32_t App_stoppedSince(const t_ObjectRecord * object)
+{
+    return App_beltStoppedTime() - App_trackedStoppedTime[object - App_trackedObjects];
+}
+
+/* Register a new object detected by distance
+ *
+ * input: timestamp - millis() of the object front at the proximity sensor
+ *        height - object height in millimetres
+ * output: pointer to the new record, nullptr if tracking is full
+ */
+static t_ObjectRecord * App_trackObject(uint32_t timestamp, uint16_t height)
+{
+    if (App_trackedObjectsCount >= OBJECT_TRACKING_CAPACITY)
+        return nullptr;
+
+    uint8_t index = (App_trackedObjectsHead + App_trackedObjectsCount) % OBJECT_TRACKING_CAPACITY;
+    t_ObjectRecord * object = &App_trackedObjects[index];
+
+    object->sequence = ++App_objectSequence;
+    object->timestamp = timestamp;
+    object->dwell = 0;
+    object->height = height;
+    object->epoch = 0;
+    object->color = {0, 0, 0, 0};
+    App_trackedStoppedTime[index] = App_beltStoppedTime();
+
+    App_trackedObjectsCount++;
+    return object;
+}
+
+/* Get the oldest object not yet captured by color
+ *
+ * input: none
+ * output: pointer to the record, nullptr if no object is in flight
+ */
+static t_ObjectRecord * App_getTrackedObject(void)
+{
+    if (App_trackedObjectsCount == 0)
+        return nullptr;
+
+    return &App_trackedObjects[App_trackedObjectsHead];
+}
+
+/* Remove the oldest object from tracking
+ *
+ */
+static void App_releaseTrackedObject(void)
+{
+    if (App_trackedObjectsCount == 0)
+        return;
+
+    App_trackedObjectsHead = (App_trackedObjectsHead + 1) % OBJECT_TRACKING_CAPACITY;
+    App_trackedObjectsCount--;
+}
+
+/* Identity of the sensors and of the settings baselines depend on */
+static uint32_t App_sensorFingerprint(void)
+{
+    return ((uint32_t)colorSensor.read8(TCS34725_ID) << 24) |
+            ((uint32_t)COLOR_PREVIEW_INTEGRATION_TIME << 16) |
+            ((uint32_t)COLOR_PREVIEW_GAIN << 8) |
+            CALIB_PROFILE_VERSION;
+}
+
+static void App_saveProfile(void)
+{
+    App_profile.fingerprint = App_sensorFingerprint();
+    App_profile.color = App_colorSensorBaseline;
+    App_profile.clear = App_colorSensorClearBaseline;
+    App_profile.distance = App_proximitySensorBaseline;
+
+    if (!CalibrationStore_save(&App_profile))
+        Serial.println("Calibration profile not saved");
+
+    App_profileSaveTime = millis();
+}
+
+#if (APP_TRACE_READINGS == 1)
+/* Raw sensor readings on Serial, replayed by the host tests (test/host) */
+static void App_traceColor(uint16_t red, uint16_t green, uint16_t blue, uint16_t clear)
+{
+    Serial.printf("trace color %u %u %u %u %u %u %u\n", (uint32_t)millis(), clear, red, green, blue,
+            App_colorSensorIntegrationTime, (uint8_t)App_colorSensorGain);
+}
+
+static void App_traceDistance(uint16_t distance)
+{
+    Serial.printf("trace distance %u %u\n", (uint32_t)millis(), distance);
+}
+#else
+#define App_traceColor(red, green, blue, clear)
+#define App_traceDistance(distance)
+#endif
+
+/* Check saved baselines against a few quick readings of the empty belt
+ *
+ * output: -1 if they do not match, 1 if they do, 0 while readings are pending
+ */
+static int8_t App_validateProfile(void)
+{
+    static uint8_t colorCycles = 0, proximityCycles = 0;
+    static bool valid = true;
+
+    if (proximityCycles < CALIB_PROFILE_VALIDATION_CYCLES)
+    {
+        if (proximitySensor.data_available() & DISTANCE)
+        {
+            uint16_t distance = proximitySensor.get_distance();
+            App_traceDistance(distance);
+            uint16_t error = (distance > App_profile.distance) ? (distance - App_profile.distance) : (App_profile.distance - distance);
+
+            valid &= (error <= PROXIMITY_SENSOR_NOISE);
+            proximityCycles++;
+            proximitySensor.request_distance();
+        }
+    }
+
+    uint16_t rawRed, rawGreen, rawBlue, rawClear;
+    if ((colorCycles < CALIB_PROFILE_VALIDATION_CYCLES) && colorSensor.getRawDataAsync(&rawRed, &rawGreen, &rawBlue, &rawClear))
+    {
+        App_traceColor(rawRed, rawGreen, rawBlue, rawClear);
+
+        uint8_t red, green, blue;
+        colorSensor.normalizeRGB(rawRed, rawGreen, rawBlue, rawClear, &red, &green, &blue);
+
+        uint32_t clearMargin = ((uint32_t)App_profile.clear * COLOR_SENSOR_INTERRUPT_MARGIN) / 100;
+        uint16_t clearError = (rawClear > App_profile.clear) ? (rawClear - App_profile.clear) : (App_profile.clear - rawClear);
+
+        valid &= (abs(red - App_profile.color.red) <= COLOR_OBJECT_DETECTION_THRESHOLD) &&
+                (abs(green - App_profile.color.green) <= COLOR_OBJECT_DETECTION_THRESHOLD) &&
+                (abs(blue - App_profile.color.blue) <= COLOR_OBJECT_DETECTION_THRESHOLD) &&
+                (clearError <= clearMargin);
+        colorCycles++;
+    }
+
+    if (!valid)
+        return -1;
+
+    if ((proximityCycles < CALIB_PROFILE_VALIDATION_CYCLES) || (colorCycles < CALIB_PROFILE_VALIDATION_CYCLES))
+        return 0;
+
+    return 1;
+}
+
+/* Distance bytes arrived on UART (UART event task) */
+static void App_proximitySensorReceive(void)
+{
+    if (App_wakeCallback != nullptr)
+        App_wakeCallback(false);
+}
 
 void App_init(void)
 {
@@ -40,11 +282,26 @@ void App_init(void)
     }
     Serial.println("Color sensor OK");
 
+    ColorClassifier_init();
+
+    SampleHistory_init(&App_distanceHistory, PROXIMITY_MEDIAN_WINDOW);
+    for (uint8_t i = 0; i < 3; i++)
+        SampleHistory_init(&App_colorHistory[i], COLOR_MEDIAN_WINDOW);
+
+    Presence_init(&App_distancePresence);
+    Presence_init(&App_colorPresence);
+
     /* Initialize and calibrate proximity sensor */
     proximitySensor.begin();
+    Serial2.onReceive(App_proximitySensorReceive);
     proximitySensor.request_distance();
 
-    App_state = APP_SENSOR_PREPARE;
+    /* Skip calibration if baselines saved for this sensor set-up are still right */
+    uint32_t fingerprint = App_sensorFingerprint();
+    if (CalibrationStore_load(&App_profile) && (App_profile.fingerprint == fingerprint))
+        App_state = APP_PROFILE_VALIDATE;
+    else
+        App_state = APP_SENSOR_PREPARE;
 }
 
 static bool App_calibrateProximitySensor(void)
@@ -61,6 +318,7 @@ static bool App_calibrateProximitySensor(void)
     if (proximitySensor.data_available() & DISTANCE)
     {
         uint16_t distance = proximitySensor.get_distance();
+        App_traceDistance(distance);
 
         /* Initial values for first cycle */
         if (cycles == 0)
@@ -92,22 +350,33 @@ static bool App_calibrateProximitySensor(void)
 static bool App_calibrateColorSensor(void)
 {
     static uint8_t cycles = 0;
-    cycles++;
 
-    if (cycles > COLOR_SENSOR_CALIB_CYCLES)
+    if (cycles >= COLOR_SENSOR_CALIB_CYCLES)
     {
         /* Calibration completed */
         return true;
     }
 
-    float r, g, b;
-    colorSensor.getRGB(&r, &g, &b);
+    uint16_t rawRed, rawGreen, rawBlue, rawClear;
+    if (!colorSensor.getRawDataAsync(&rawRed, &rawGreen, &rawBlue, &rawClear))
+    {
+        /* Wait for integration cycle to complete */
+        return false;
+    }
+
+    App_traceColor(rawRed, rawGreen, rawBlue, rawClear);
+
+    uint8_t r, g, b;
+    colorSensor.normalizeRGB(rawRed, rawGreen, rawBlue, rawClear, &r, &g, &b);
 
     /* Calculate sum of all cycles */
     static uint16_t red = 0, green = 0, blue = 0;
-    red   += (uint8_t)r;
-    green += (uint8_t)g;
-    blue  += (uint8_t)b;
+    static uint32_t clear = 0;
+    red   += r;
+    green += g;
+    blue  += b;
+    clear += rawClear;
+    cycles++;
 
     /* Finally divide the sum by number of cycles */
     if (cycles == COLOR_SENSOR_CALIB_CYCLES)
@@ -115,18 +384,537 @@ static bool App_calibrateColorSensor(void)
         App_colorSensorBaseline.red = (uint8_t)(red / COLOR_SENSOR_CALIB_CYCLES);
         App_colorSensorBaseline.green = (uint8_t)(green / COLOR_SENSOR_CALIB_CYCLES);
         App_colorSensorBaseline.blue = (uint8_t)(blue / COLOR_SENSOR_CALIB_CYCLES);
+        App_colorSensorClearBaseline = (uint16_t)(clear / COLOR_SENSOR_CALIB_CYCLES);
+        return true;
     }
 
     /* Calibration in progress */
     return false;
 }
 
+#if (COLOR_SENSOR_INTERRUPT_MODE == 1)
+static void IRAM_ATTR App_colorSensorIsr(void)
+{
+    App_colorSensorInterrupt = true;
+
+    if (App_wakeCallback != nullptr)
+        App_wakeCallback(true);
+}
+#endif
+
+/* Program the clear-channel interrupt window around the idle baseline
+ * so the sensor only raises INT when the light level changes
+ */
+static void App_setColorSensorInterruptWindow(void)
+{
+#if (COLOR_SENSOR_INTERRUPT_MODE == 1)
+    uint32_t margin = ((uint32_t)App_colorSensorClearBaseline * COLOR_SENSOR_INTERRUPT_MARGIN) / 100;
+    uint32_t low = (App_colorSensorClearBaseline > margin) ? (App_colorSensorClearBaseline - margin) : 0;
+    uint32_t high = App_colorSensorClearBaseline + margin;
+
+    if (high > UINT16_MAX)
+        high = UINT16_MAX;
+
+    colorSensor.setIntLimits((uint16_t)low, (uint16_t)high);
+    App_colorInterruptClear = App_colorSensorClearBaseline;
+#endif
+}
+
+static void App_armColorSensorInterrupt(void)
+{
+#if (COLOR_SENSOR_INTERRUPT_MODE == 1)
+    App_setColorSensorInterruptWindow();
+    colorSensor.write8(TCS34725_PERS, TCS34725_PERS_1_CYCLE);
+    colorSensor.setInterrupt(true);
+    colorSensor.clearInterrupt();
+
+    pinMode(COLOR_SENSOR_INT_PIN, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(COLOR_SENSOR_INT_PIN), App_colorSensorIsr, FALLING);
+
+    /* Force a first reading in case INT was already asserted */
+    App_colorSensorInterrupt = true;
+#endif
+}
+
+/* Check whether the color sensor has to be read
+ *
+ * input: idle - true if there is neither an object expected nor one being tracked
+ * output: true if a reading is needed, false if it can be skipped
+ */
+static bool App_colorSensorNeedsReading(bool idle)
+{
+#if (COLOR_SENSOR_INTERRUPT_MODE == 1)
+    /* Also read now and then to keep tracking the baseline */
+    return (App_colorSensorInterrupt || !idle || ((millis() - App_colorSensorLastReading) >= COLOR_BASELINE_PERIOD));
+#else
+    (void)idle;
+    return true;
+#endif
+}
+
+/* Release INT once the reading that served it was taken,
+ * the sensor raises it again after the next integration
+ * cycle if light is still out of window
+ */
+static void App_acknowledgeColorSensorInterrupt(void)
+{
+#if (COLOR_SENSOR_INTERRUPT_MODE == 1)
+    if (App_colorSensorInterrupt)
+    {
+        App_colorSensorInterrupt = false;
+        colorSensor.clearInterrupt();
+    }
+#endif
+}
+
+/* Move a Q8 baseline toward a reading by 1/filter of the difference,
+ * at most maxStep, and never further than limit from the reference
+ *
+ * output: true if the baseline is held at the limit (anomaly)
+ */
+static bool App_trackBaseline(uint32_t * track, uint16_t reading, uint16_t filter, int32_t maxStep, uint16_t reference, uint16_t limit)
+{
+    int32_t step = (((int32_t)reading << 8) - (int32_t)*track) / (int32_t)filter;
+
+    if (step > maxStep)
+        step = maxStep;
+    else if (step < -maxStep)
+        step = -maxStep;
+
+    int32_t next = (int32_t)*track + step;
+    int32_t low = ((reference > limit) ? (int32_t)(reference - limit) : 0) << 8;
+    int32_t high = ((int32_t)reference + limit) << 8;
+    bool anomaly = false;
+
+    if (next < low)
+    {
+        next = low;
+        anomaly = true;
+    }
+    else if (next > high)
+    {
+        next = high;
+        anomaly = true;
+    }
+
+    *track = (uint32_t)next;
+    return anomaly;
+}
+
+static uint16_t App_baselineValue(uint32_t track)
+{
+    return (uint16_t)((track + 128) >> 8);
+}
+
+static void App_setBaselineFlag(uint8_t flag, bool set, const char * sensor)
+{
+    if (set == ((App_baselineFlags & flag) != 0))
+        return;
+
+    if (set)
+        App_baselineFlags |= flag;
+    else
+        App_baselineFlags &= ~flag;
+
+    Serial.printf("%s baseline %s\n", sensor, set ? "out of range" : "back in range");
+}
+
+/* Start tracking from the calibrated baselines */
+static void App_startBaselineTracking(void)
+{
+    App_colorCalibratedBaseline = App_colorSensorBaseline;
+    App_colorCalibratedClear = App_colorSensorClearBaseline;
+    App_proximityCalibratedBaseline = App_proximitySensorBaseline;
+
+    App_colorBaselineTrack[0] = (uint32_t)App_colorSensorBaseline.red << 8;
+    App_colorBaselineTrack[1] = (uint32_t)App_colorSensorBaseline.green << 8;
+    App_colorBaselineTrack[2] = (uint32_t)App_colorSensorBaseline.blue << 8;
+    App_colorBaselineTrack[3] = (uint32_t)App_colorSensorClearBaseline << 8;
+    App_proximityBaselineTrack = (uint32_t)App_proximitySensorBaseline << 8;
+    App_baselineFlags = 0;
+}
+
+/* Follow slow light changes with a reading of the empty belt */
+static void App_trackColorBaseline(uint8_t red, uint8_t green, uint8_t blue, uint16_t clear)
+{
+    uint16_t clearLimit = (uint16_t)(((uint32_t)App_colorCalibratedClear * COLOR_BASELINE_CLEAR_ANOMALY) / 100);
+    bool anomaly = false;
+
+    anomaly |= App_trackBaseline(&App_colorBaselineTrack[0], red, COLOR_BASELINE_FILTER, COLOR_BASELINE_MAX_STEP,
+            App_colorCalibratedBaseline.red, COLOR_BASELINE_ANOMALY);
+    anomaly |= App_trackBaseline(&App_colorBaselineTrack[1], green, COLOR_BASELINE_FILTER, COLOR_BASELINE_MAX_STEP,
+            App_colorCalibratedBaseline.green, COLOR_BASELINE_ANOMALY);
+    anomaly |= App_trackBaseline(&App_colorBaselineTrack[2], blue, COLOR_BASELINE_FILTER, COLOR_BASELINE_MAX_STEP,
+            App_colorCalibratedBaseline.blue, COLOR_BASELINE_ANOMALY);
+    anomaly |= App_trackBaseline(&App_colorBaselineTrack[3], clear, COLOR_BASELINE_FILTER, COLOR_BASELINE_MAX_STEP * 16,
+            App_colorCalibratedClear, clearLimit);
+
+    App_colorSensorBaseline.red = (uint8_t)App_baselineValue(App_colorBaselineTrack[0]);
+    App_colorSensorBaseline.green = (uint8_t)App_baselineValue(App_colorBaselineTrack[1]);
+    App_colorSensorBaseline.blue = (uint8_t)App_baselineValue(App_colorBaselineTrack[2]);
+    App_colorSensorClearBaseline = App_baselineValue(App_colorBaselineTrack[3]);
+
+    App_setBaselineFlag(APP_BASELINE_COLOR_ANOMALY, anomaly, "Color");
+
+    /* Keep the interrupt window centered once the baseline moved by a quarter of it */
+    uint16_t shift = (App_colorSensorClearBaseline > App_colorInterruptClear) ?
+            (App_colorSensorClearBaseline - App_colorInterruptClear) : (App_colorInterruptClear - App_colorSensorClearBaseline);
+    if (shift > (((uint32_t)App_colorInterruptClear * COLOR_SENSOR_INTERRUPT_MARGIN) / 400))
+        App_setColorSensorInterruptWindow();
+}
+
+/* Follow slow belt distance changes with a reading of the empty belt */
+static void App_trackProximityBaseline(uint16_t distance)
+{
+    bool anomaly = App_trackBaseline(&App_proximityBaselineTrack, distance, PROXIMITY_BASELINE_FILTER, PROXIMITY_BASELINE_MAX_STEP,
+            App_proximityCalibratedBaseline, PROXIMITY_BASELINE_ANOMALY);
+
+    App_proximitySensorBaseline = App_baselineValue(App_proximityBaselineTrack);
+    App_setBaselineFlag(APP_BASELINE_PROXIMITY_ANOMALY, anomaly, "Proximity");
+}
+
 static void App_setMotor(bool state)
 {
     if (App_motorCallback != nullptr)
         App_motorCallback(state);
 }
 
+/* Update belt speed from the travel time of an object front
+ * between proximity and color sensor
+ *
+ * input: object - record of the object
+ *        colorEdge - millis() of the object front at the color sensor
+ * output: none
+ */
+static void App_measureBeltSpeed(const t_ObjectRecord * object, uint32_t colorEdge)
+{
+    uint32_t transit = colorEdge - object->timestamp;
+
+    /* Start and stop ramps of the motor make a transit with a stop a poor measurement */
+    if ((transit == 0) || (App_stoppedSince(object) > 0))
+        return;
+
+    uint32_t speed = ((uint32_t)SENSOR_SPACING * 1000) / transit;
+    if (speed > UINT16_MAX)
+        return;
+
+    if (App_beltEstimate.speed == 0)
+        App_beltEstimate.speed = (uint16_t)speed;
+    else
+        App_beltEstimate.speed = (uint16_t)((int32_t)App_beltEstimate.speed + ((int32_t)speed - App_beltEstimate.speed) / BELT_SPEED_FILTER);
+
+    App_beltEstimate.transitTime = transit;
+}
+
+/* Predict when the object center will be under the color sensor
+ *
+ * input: object - record of the object
+ *        captureTime - pointer to a buffer that receives the millis() of the prediction
+ * output: true if a prediction is available, false otherwise
+ */
+static bool App_predictCaptureTime(const t_ObjectRecord * object, uint32_t * captureTime)
+{
+    /* Needs a known speed and a complete pass under the proximity sensor */
+    if ((App_beltEstimate.speed == 0) || (object->dwell == 0))
+        return false;
+
+    /* Travel with the belt running, later by the time it stood still so far */
+    *captureTime = object->timestamp + (object->dwell / 2) + (((uint32_t)SENSOR_SPACING * 1000) / App_beltEstimate.speed) +
+            App_stoppedSince(object);
+    return true;
+}
+
+/* Exposure settings for object color capture */
+typedef struct
+{
+    uint8_t integrationTime;
+    tcs34725Gain_t gain;
+} t_ColorExposure;
+
+/* Integration times available to the exposure controller, shortest first */
+static const uint8_t App_exposureIntegrationTimes[] = {
+    TCS34725_INTEGRATIONTIME_2_4MS,
+    TCS34725_INTEGRATIONTIME_24MS,
+    TCS34725_INTEGRATIONTIME_50MS,
+    TCS34725_INTEGRATIONTIME_101MS,
+    TCS34725_INTEGRATIONTIME_154MS,
+    TCS34725_INTEGRATIONTIME_199MS
+};
+
+/* Gains available to the exposure controller, highest first */
+static const tcs34725Gain_t App_exposureGains[] = {
+    TCS34725_GAIN_60X,
+    TCS34725_GAIN_16X,
+    TCS34725_GAIN_4X,
+    TCS34725_GAIN_1X
+};
+
+static uint32_t App_gainFactor(tcs34725Gain_t gain)
+{
+    switch (gain)
+    {
+        case TCS34725_GAIN_4X:  return 4;
+        case TCS34725_GAIN_16X: return 16;
+        case TCS34725_GAIN_60X: return 60;
+        default:                return 1;
+    }
+}
+
+/* Counts scale with integration cycles times gain */
+static uint32_t App_exposure(uint8_t integrationTime, tcs34725Gain_t gain)
+{
+    return (uint32_t)(256 - integrationTime) * App_gainFactor(gain);
+}
+
+/* Set the color sensor exposure and restart integration with it */
+static void App_setColorExposure(uint8_t integrationTime, tcs34725Gain_t gain)
+{
+    colorSensor.setIntegrationTime(integrationTime);
+    colorSensor.setGain(gain);
+    colorSensor.startConversion();
+    App_colorSensorIntegrationTime = integrationTime;
+    App_colorSensorGain = gain;
+}
+
+/* Scale a raw clear count of the running exposure to preview exposure,
+ * the exposure the clear baseline and the interrupt window are taken at
+ *
+ * input: raw clear count
+ * output: clear count at preview exposure
+ */
+static uint16_t App_previewClear(uint16_t rawClear)
+{
+    uint32_t previewExposure = App_exposure(COLOR_PREVIEW_INTEGRATION_TIME, COLOR_PREVIEW_GAIN);
+    uint32_t exposure = App_exposure(App_colorSensorIntegrationTime, App_colorSensorGain);
+    if (exposure == previewExposure)
+        return rawClear;
+
+    uint32_t clear = ((uint32_t)rawClear * previewExposure) / exposure;
+    return (clear > 0xFFFF) ? 0xFFFF : (uint16_t)clear;
+}
+
+/* Pick the shortest integration time (and the highest gain for it)
+ * whose predicted clear count reaches COLOR_EXPOSURE_TARGET_CLEAR
+ * without crossing the DN40 saturation level
+ *
+ * input: clear - clear count of last preview sample
+ *        longestIntegrationTime - longest integration time allowed
+ * output: exposure settings for capture
+ */
+static t_ColorExposure App_selectExposure(uint16_t clear, uint8_t longestIntegrationTime)
+{
+    uint32_t previewExposure = App_exposure(COLOR_PREVIEW_INTEGRATION_TIME, COLOR_PREVIEW_GAIN);
+
+    /* A saturated preview only gives a lower bound */
+    uint16_t previewSat = Adafruit_TCS34725::saturationLevel(COLOR_PREVIEW_INTEGRATION_TIME);
+    if (clear > previewSat)
+        clear = previewSat;
+
+    /* Fallback: the brightest setting that does not saturate */
+    t_ColorExposure best = {TCS34725_INTEGRATIONTIME_2_4MS, TCS34725_GAIN_1X};
+    uint32_t bestCounts = 0;
+
+    for (uint8_t i = 0; i < sizeof(App_exposureIntegrationTimes); i++)
+    {
+        uint8_t it = App_exposureIntegrationTimes[i];
+        if ((256 - it) > (256 - longestIntegrationTime))
+            break;
+
+        uint32_t sat = Adafruit_TCS34725::saturationLevel(it);
+
+        for (uint8_t j = 0; j < (sizeof(App_exposureGains) / sizeof(App_exposureGains[0])); j++)
+        {
+            tcs34725Gain_t gain = App_exposureGains[j];
+            uint32_t exposure = App_exposure(it, gain);
+            uint32_t predicted = ((uint32_t)clear * exposure) / previewExposure;
+
+            if (predicted >= sat)
+                continue;
+
+            if (predicted >= COLOR_EXPOSURE_TARGET_CLEAR)
+                return {it, gain};
+
+            if (predicted > bestCounts)
+            {
+                bestCounts = predicted;
+                best = {it, gain};
+            }
+        }
+    }
+
+    return best;
+}
+
+/* Pair the captured color with the oldest object in flight
+ * and hand the record over to the application
+ */
+static void App_reportObjectColor(t_Color * color)
+{
+    t_ObjectRecord * object = App_getTrackedObject();
+    if (object == nullptr)
+        return;
+
+    object->color = *color;
+    ColorClassifier_classify(&object->color);
+
+    if (App_startupReport.firstDetectionTime == 0)
+    {
+        App_startupReport.firstDetectionTime = millis();
+        Serial.printf("First detection after %u ms\n", App_startupReport.firstDetectionTime);
+    }
+
+    if (App_objectDetectionCallback != nullptr)
+        App_objectDetectionCallback(object);
+
+    App_releaseTrackedObject();
+}
+
+static void App_restorePreviewExposure(void)
+{
+    /* Discard the cycle started with capture exposure */
+    App_setColorExposure(COLOR_PREVIEW_INTEGRATION_TIME, COLOR_PREVIEW_GAIN);
+}
+
+/* Switch the color sensor to capture exposure.
+ * In stop-and-read mode the motor is stopped for a precise reading
+ * collected later by App_finishColorCapture(), in flying mode
+ * the sensor keeps sampling short exposures while the object moves
+ *
+ * input: color of the preview sample that triggered the capture
+ * output: none
+ */
+static void App_startColorCapture(const t_Color * previewColor)
+{
+    App_activeCaptureMode = App_captureMode;
+
+    t_ColorExposure exposure;
+
+    if (App_activeCaptureMode == APP_CAPTURE_FLYING)
+    {
+        /* The triggering sample already shows the object */
+        App_flyingSamples[0] = *previewColor;
+        App_flyingSampleCount = 1;
+        exposure = App_selectExposure(App_colorSensorLastClear, COLOR_PREVIEW_INTEGRATION_TIME);
+    }
+    else
+    {
+        App_colorCaptureInProgress = true;
+        App_setMotor(false);
+        App_updateBeltMotion();
+        exposure = App_selectExposure(App_colorSensorLastClear, TCS34725_INTEGRATIONTIME_199MS);
+    }
+
+    App_setColorExposure(exposure.integrationTime, exposure.gain);
+}
+
+/* Collect the object color once the capture integration completes
+ *
+ * input: none
+ * output: true when the capture is completed, false while still integrating
+ */
+static bool App_finishColorCapture(void)
+{
+    uint16_t rawRed, rawGreen, rawBlue, rawClear;
+    if (!colorSensor.getRawDataAsync(&rawRed, &rawGreen, &rawBlue, &rawClear))
+        return false;
+
+    App_traceColor(rawRed, rawGreen, rawBlue, rawClear);
+    uint16_t clear = App_previewClear(rawClear);
+    App_restorePreviewExposure();
+
+    uint8_t rx, gx, bx;
+    colorSensor.normalizeRGB(rawRed, rawGreen, rawBlue, rawClear, &rx, &gx, &bx);
+
+    t_Color newObjColor = {rx, gx, bx, clear};
+    App_reportObjectColor(&newObjColor);
+
+    /* Belt runs again unless overheight came up meanwhile */
+    App_colorCaptureInProgress = false;
+    App_setMotor(App_getMotorCondition());
+    App_updateBeltMotion();
+
+    return true;
+}
+
+/* Check whether samples [first, last] of flying capture
+ * stay within the plateau tolerance on every channel
+ */
+static bool App_isFlyingPlateau(uint8_t first, uint8_t last)
+{
+    const t_Color * ref = &App_flyingSamples[first];
+    uint8_t low[3] = {ref->red, ref->green, ref->blue};
+    uint8_t high[3] = {ref->red, ref->green, ref->blue};
+
+    for (uint8_t i = first + 1; i <= last; i++)
+    {
+        const t_Color * sample = &App_flyingSamples[i];
+        uint8_t value[3] = {sample->red, sample->green, sample->blue};
+
+        for (uint8_t ch = 0; ch < 3; ch++)
+        {
+            if (value[ch] < low[ch])
+                low[ch] = value[ch];
+            if (value[ch] > high[ch])
+                high[ch] = value[ch];
+
+            if ((high[ch] - low[ch]) > COLOR_FLYING_PLATEAU_TOLERANCE)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/* Pick the object color from flying capture samples:
+ * leading and trailing samples (object edges) are rejected,
+ * then the longest stable run of samples is averaged
+ */
+static void App_finishFlyingCapture(void)
+{
+    App_restorePreviewExposure();
+
+    uint8_t first = 0, last = App_flyingSampleCount - 1;
+
+    /* Edge rejection */
+    if (App_flyingSampleCount >= 3)
+    {
+        first++;
+        last--;
+    }
+
+    /* Longest plateau, a single sample is the degenerate case */
+    uint8_t bestFirst = first, bestLength = 1;
+    for (uint8_t i = first; i <= last; i++)
+    {
+        for (uint8_t j = i + bestLength; j <= last; j++)
+        {
+            if (!App_isFlyingPlateau(i, j))
+                break;
+
+            bestFirst = i;
+            bestLength = j - i + 1;
+        }
+    }
+
+    uint16_t red = 0, green = 0, blue = 0;
+    uint32_t clear = 0;
+    for (uint8_t i = bestFirst; i < (bestFirst + bestLength); i++)
+    {
+        red   += App_flyingSamples[i].red;
+        green += App_flyingSamples[i].green;
+        blue  += App_flyingSamples[i].blue;
+        clear += App_flyingSamples[i].clear;
+    }
+
+    t_Color newObjColor = {
+        (uint8_t)(red / bestLength),
+        (uint8_t)(green / bestLength),
+        (uint8_t)(blue / bestLength),
+        (uint16_t)(clear / bestLength)
+    };
+    App_reportObjectColor(&newObjColor);
+}
+
 static void App_readColorSensor(void)
 {
     static enum {
@@ -135,28 +923,93 @@ static void App_readColorSensor(void)
         COLOR_OBJECT_REGISTERED
     } objectColorDetectionState = COLOR_NO_OBJECT;
 
-    static uint8_t objectColorDetectionCounter = 0;
+    static uint32_t colorEdge = 0; /* millis() of the first sample showing the object */
+
+    /* Object color capture in progress, sensor is busy with capture exposure */
+    if ((objectColorDetectionState == COLOR_NEW_OBJECT) && (App_activeCaptureMode == APP_CAPTURE_STOP_AND_READ))
+    {
+        App_colorSensorIdle = false;
+        if (App_finishColorCapture())
+            objectColorDetectionState = COLOR_OBJECT_REGISTERED;
+        return;
+    }
+
+    /* Drop an object that never showed up under the color sensor (e.g. removed by hand) */
+    t_ObjectRecord * expectedObject = App_getTrackedObject();
+    if ((objectColorDetectionState == COLOR_NO_OBJECT) && (expectedObject != nullptr) &&
+            ((millis() - expectedObject->timestamp) > OBJECT_TRACKING_TIMEOUT))
+    {
+        Serial.printf("Object %u lost\n", expectedObject->sequence);
+        App_releaseTrackedObject();
+        expectedObject = App_getTrackedObject();
+    }
+
+    bool expectingObject = (expectedObject != nullptr);
+    App_colorSensorIdle = ((objectColorDetectionState == COLOR_NO_OBJECT) && !expectingObject);
+
+    /* Nothing on the belt, leave the bus alone until the sensor interrupt fires */
+    if (!App_colorSensorNeedsReading(App_colorSensorIdle))
+        return;
+
+    uint16_t rawRed, rawGreen, rawBlue, rawClear;
+    if (!colorSensor.getRawDataAsync(&rawRed, &rawGreen, &rawBlue, &rawClear))
+    {
+        /* Sensor still integrating, try again on next cycle */
+        return;
+    }
 
-    float r, g, b;
-    colorSensor.getRGB(&r, &g, &b);
+    App_acknowledgeColorSensorInterrupt();
+    App_colorSensorLastReading = millis();
+    App_traceColor(rawRed, rawGreen, rawBlue, rawClear);
 
     uint8_t red, green, blue;
-    red   = (uint8_t)r;
-    green = (uint8_t)g;
-    blue  = (uint8_t)b;
+    colorSensor.normalizeRGB(rawRed, rawGreen, rawBlue, rawClear, &red, &green, &blue);
 
-    /* Calculate color difference of sensor reading against baseline */
-    uint8_t delta_red, delta_green, delta_blue;
-    delta_red = abs(red - App_colorSensorBaseline.red);
-    delta_green = abs(green - App_colorSensorBaseline.green);
-    delta_blue = abs(blue - App_colorSensorBaseline.blue);
+    /* Flying capture samples at capture exposure, compare brightness at preview exposure */
+    uint16_t clear = App_previewClear(rawClear);
+    App_colorSensorLastClear = clear;
+
+    /* A saturated reading at capture exposure shows something brighter than the object
+     * (the belt again), its color and brightness are clipped: end the flying capture
+     * without letting it count as a sample or as presence evidence */
+    if ((objectColorDetectionState == COLOR_NEW_OBJECT) &&
+            (rawClear >= Adafruit_TCS34725::saturationLevel(App_colorSensorIntegrationTime)))
+    {
+        App_finishFlyingCapture();
+        objectColorDetectionState = COLOR_OBJECT_REGISTERED;
+        return;
+    }
 
-    /* Check if an object with color different from baseline is detected */
-    bool thereIsObject = ((delta_red > COLOR_OBJECT_DETECTION_THRESHOLD) ||
-            (delta_green > COLOR_OBJECT_DETECTION_THRESHOLD) ||
-            (delta_blue > COLOR_OBJECT_DETECTION_THRESHOLD));
+    /* Decide on the rolling median, a single noisy reading does not count */
+    SampleHistory_add(&App_colorHistory[0], red);
+    SampleHistory_add(&App_colorHistory[1], green);
+    SampleHistory_add(&App_colorHistory[2], blue);
 
-    bool expectingObject = (App_detectionState == OBJECT_DETECTED_BY_DISTANCE);
+    /* Calculate color difference of sensor reading against baseline */
+    uint8_t delta_red, delta_green, delta_blue;
+    delta_red = abs(SampleHistory_median(&App_colorHistory[0]) - App_colorSensorBaseline.red);
+    delta_green = abs(SampleHistory_median(&App_colorHistory[1]) - App_colorSensorBaseline.green);
+    delta_blue = abs(SampleHistory_median(&App_colorHistory[2]) - App_colorSensorBaseline.blue);
+
+    uint8_t delta_color = delta_red;
+    if (delta_green > delta_color)
+        delta_color = delta_green;
+    if (delta_blue > delta_color)
+        delta_color = delta_blue;
+
+    int32_t delta_clear = abs((int32_t)clear - App_colorSensorClearBaseline);
+    uint16_t clearSigma = (uint16_t)(((uint32_t)App_colorSensorClearBaseline * PRESENCE_CLEAR_SIGMA_PERCENT) / 100);
+
+    /* Fuse color and brightness change into one decision on object presence */
+    Presence_update(&App_colorPresence,
+            Presence_evidence(delta_color, PRESENCE_COLOR_SIGMA) + Presence_evidence(delta_clear, clearSigma));
+    bool thereIsObject = (App_colorPresence.state == PRESENCE_OBJECT);
+
+    /* Nothing expected under the sensor and readings agree the belt is empty
+     * (not a hand or an object the proximity sensor missed) */
+    if ((objectColorDetectionState == COLOR_NO_OBJECT) && !expectingObject &&
+            (App_colorPresence.state == PRESENCE_EMPTY) && (App_colorPresence.evidence == 0))
+        App_trackColorBaseline(red, green, blue, clear);
 
     // Serial.printf("Color object detected/expecting: %d/%d\n", thereIsObject, expectingObject);
 
@@ -165,51 +1018,44 @@ static void App_readColorSensor(void)
         case COLOR_NO_OBJECT:
             if (thereIsObject && expectingObject)
             {
-                if (objectColorDetectionCounter < OBJECT_COLOR_DETECTION_HYSTERESIS)
-                    objectColorDetectionCounter++;
-                else
-                    objectColorDetectionState = COLOR_NEW_OBJECT;
-            }
-            else
-                objectColorDetectionCounter = 0;
-            break;
+                colorEdge = App_colorPresence.edge;
 
-        case COLOR_NEW_OBJECT:
-        {
-            // Serial.println("Registering new object color");
+                /* Capture when the object center is predicted under the sensor,
+                 * as soon as presence is decided without a valid prediction */
+                uint32_t captureTime;
+                bool captureNow = true;
+                if (App_predictCaptureTime(expectedObject, &captureTime))
+                    captureNow = ((int32_t)(millis() - captureTime) >= 0);
 
-            App_setMotor(false);
+                if (captureNow)
+                {
+                    // Serial.println("Registering new object color");
+                    App_measureBeltSpeed(expectedObject, colorEdge);
 
-            float rx, gx, bx;
-            colorSensor.setIntegrationTime(TCS34725_INTEGRATIONTIME_199MS);
-            colorSensor.getRGB(&rx, &gx, &bx);
-            colorSensor.setIntegrationTime(TCS34725_INTEGRATIONTIME_24MS);
+                    t_Color previewColor = {red, green, blue, clear};
+                    App_startColorCapture(&previewColor);
+                    objectColorDetectionState = COLOR_NEW_OBJECT;
+                }
+            }
+            break;
 
-            if (App_objectDetectionCallback != nullptr)
+        case COLOR_NEW_OBJECT: /* Flying capture only */
+            if (thereIsObject)
             {
-                t_Color newObjColor = {(uint8_t)rx, (uint8_t)gx, (uint8_t)bx, 0};
-                App_objectDetectionCallback(&newObjColor);
+                App_flyingSamples[App_flyingSampleCount] = {red, green, blue, clear};
+                App_flyingSampleCount++;
             }
 
-            App_setMotor(true);
-
-            objectColorDetectionState = COLOR_OBJECT_REGISTERED;
+            if (!thereIsObject || (App_flyingSampleCount >= COLOR_FLYING_CAPTURE_SAMPLES))
+            {
+                App_finishFlyingCapture();
+                objectColorDetectionState = COLOR_OBJECT_REGISTERED;
+            }
             break;
-        }
 
         case COLOR_OBJECT_REGISTERED:
             if (!thereIsObject)
-            {
-                if (objectColorDetectionCounter > 0)
-                    objectColorDetectionCounter--;
-                else
-                {
-                    objectColorDetectionState = COLOR_NO_OBJECT;
-                    App_detectionState = OBJECT_DETECTED_BY_COLOR;
-                }
-            }
-            else
-                objectColorDetectionCounter = OBJECT_COLOR_DETECTION_HYSTERESIS;
+                objectColorDetectionState = COLOR_NO_OBJECT;
             break;
 
         default:
@@ -232,7 +1078,9 @@ static void App_readProximitySensor(void)
     } objectDistanceDetectionState = PROXIMITY_IN_RANGE_NO_OBJECT;
 
     static uint8_t overheightDetectionCounter = 0;
-    static uint8_t distanceDetectionCounter = 0;
+    static t_ObjectRecord * trackedObject = nullptr; /* Object currently under the proximity sensor */
+    static uint32_t risingEdge = 0;  /* millis() of the first reading showing the object */
+    static uint32_t fallingEdge = 0; /* millis() of the first reading showing the belt again */
 
     uint16_t distance = 0;
 
@@ -241,11 +1089,22 @@ static void App_readProximitySensor(void)
     else /* Wait for sensor data */
         return;
 
+    App_traceDistance(distance);
+
     // Serial.printf("Distance: %d\n", distance);
 
     bool distanceValid = ((distance >= MINIMUM_DISTANCE) && (distance <= MAXIMUM_DISTANCE));
-    bool distanceInRange = (distance >= OVERHEIGHT_LIMIT);
-    bool objectDetected = (distance < (App_proximitySensorBaseline - PROXIMITY_SENSOR_NOISE));
+    bool distanceInRange = (distance >= OVERHEIGHT_LIMIT); /* Safety: raw reading, no filter delay */
+
+    /* Object presence and height from the rolling median, robust to single echoes */
+    if (distanceValid)
+        SampleHistory_add(&App_distanceHistory, distance);
+    distance = SampleHistory_median(&App_distanceHistory);
+
+    Presence_update(&App_distancePresence,
+            Presence_evidence((int32_t)App_proximitySensorBaseline - distance, PRESENCE_DISTANCE_SIGMA));
+    bool objectDetected = (App_distancePresence.state == PRESENCE_OBJECT);
+    uint16_t height = (App_proximitySensorBaseline > distance) ? (App_proximitySensorBaseline - distance) : 0;
 
     // Serial.printf("Distance baseline/actual: %d/%d\n", App_proximitySensorBaseline, distance);
 
@@ -282,33 +1141,54 @@ static void App_readProximitySensor(void)
             switch (objectDistanceDetectionState)
             {
                 case PROXIMITY_IN_RANGE_NO_OBJECT:
-                    App_detectionState = OBJECT_NOT_DETECTED;
-
                     if (objectDetected)
                     {
-                        if (distanceDetectionCounter < OBJECT_DISTANCE_DETECTION_HYSTERESIS)
-                            distanceDetectionCounter++;
-                        else
-                        {
-                            App_detectionState = OBJECT_DETECTED_BY_DISTANCE;
-                            objectDistanceDetectionState = PROXIMITY_IN_RANGE_NEW_OBJECT;
-                        }
+                        risingEdge = App_distancePresence.edge;
+
+                        trackedObject = App_trackObject(risingEdge, height);
+                        if (trackedObject == nullptr)
+                            Serial.println("Object tracking full");
+
+                        objectDistanceDetectionState = PROXIMITY_IN_RANGE_NEW_OBJECT;
+                    }
+                    else if (App_distancePresence.evidence == 0) /* Readings agree the belt is empty */
+                    {
+                        App_trackProximityBaseline(distance);
                     }
-                    else
-                        distanceDetectionCounter = 0;
                     break;
 
                 case PROXIMITY_IN_RANGE_NEW_OBJECT:
-                    distanceDetectionCounter = 0;
+                    /* Object still under the sensor, keep its highest point */
+                    if (objectDetected)
+                    {
+                        if ((trackedObject != nullptr) && (height > trackedObject->height))
+                            trackedObject->height = height;
+                    }
+                    /* Belt clear again */
+                    else
+                    {
+                        fallingEdge = App_distancePresence.edge;
+
+                        /* Object passed completely, its length follows from the belt speed */
+                        if (trackedObject != nullptr)
+                        {
+                            uint32_t dwell = fallingEdge - trackedObject->timestamp;
+                            uint32_t stopped = App_stoppedSince(trackedObject);
+                            trackedObject->dwell = (dwell > stopped) ? (dwell - stopped) : 1;
 
-                    if (App_detectionState == OBJECT_DETECTED_BY_COLOR)
+                            App_beltEstimate.objectLength = (uint16_t)(((uint32_t)App_beltEstimate.speed * trackedObject->dwell) / 1000);
+                        }
+
+                        trackedObject = nullptr;
                         objectDistanceDetectionState = PROXIMITY_IN_RANGE_NO_OBJECT;
+                    }
                     break;
             }
 
             /* Exit path, priority */
             if (!distanceValid)
             {
+                App_overheightCondition = true;
                 overheightDetectionCounter = OVERHEIGHT_HYSTERESIS;
                 proximityState = PROXIMITY_INVALID;
                 break;
@@ -323,6 +1203,7 @@ static void App_readProximitySensor(void)
             /* Exit path, priority */
             if (!distanceValid)
             {
+                App_overheightCondition = true;
                 overheightDetectionCounter = OVERHEIGHT_HYSTERESIS;
                 proximityState = PROXIMITY_INVALID;
                 break;
@@ -337,6 +1218,8 @@ static void App_readProximitySensor(void)
                 /* Exit path */
                 else
                 {
+                    /* Set now, the motor condition is read before the next reading */
+                    App_overheightCondition = true;
                     proximityState = PROXIMITY_OVERHEIGHT;
                     if (App_objectOverheightCallback != nullptr)
                         App_objectOverheightCallback();
@@ -358,6 +1241,19 @@ static void App_readProximitySensor(void)
     proximitySensor.request_distance();
 }
 
+/* Sensors ready: start tracking baselines and detecting objects */
+static void App_startWorking(void)
+{
+    App_startBaselineTracking();
+    App_armColorSensorInterrupt();
+    App_state = APP_WORKING;
+
+    App_startupReport.readyTime = millis();
+    Serial.printf("Color baseline: (%d,%d,%d)\n", App_colorSensorBaseline.red, App_colorSensorBaseline.green, App_colorSensorBaseline.blue);
+    Serial.printf("Sensors ready after %u ms (%s)\n", App_startupReport.readyTime,
+            App_startupReport.profileRestored ? "saved profile" : "calibrated");
+}
+
 void App_task(void)
 {
     switch (App_state)
@@ -366,6 +1262,28 @@ void App_task(void)
             App_init();
             break;
 
+        case APP_PROFILE_VALIDATE:
+        {
+            int8_t result = App_validateProfile();
+
+            if (result > 0)
+            {
+                App_colorSensorBaseline = App_profile.color;
+                App_colorSensorClearBaseline = App_profile.clear;
+                App_proximitySensorBaseline = App_profile.distance;
+                App_profileSaveTime = millis();
+
+                App_startupReport.profileRestored = true;
+                App_startWorking();
+            }
+            else if (result < 0)
+            {
+                Serial.println("Calibration profile outdated, calibrating");
+                App_state = APP_SENSOR_PREPARE;
+            }
+            break;
+        }
+
         case APP_SENSOR_PREPARE:
             /* Wait state for sensors calibration */
             if (!App_calibrateProximitySensor())
@@ -375,14 +1293,20 @@ void App_task(void)
 
             if (App_calibrateColorSensor())
             {
-                App_state = APP_WORKING;
-                Serial.printf("Color baseline: (%d,%d,%d)\n", App_colorSensorBaseline.red, App_colorSensorBaseline.green, App_colorSensorBaseline.blue);
+                App_saveProfile();
+                App_startWorking();
             }
             break;
 
         case APP_WORKING:
             App_readProximitySensor();
+            App_updateBeltMotion();
             App_readColorSensor();
+
+            /* Keep the saved profile close to tracked baselines, only with the belt empty */
+            if (((millis() - App_profileSaveTime) >= CALIB_PROFILE_SAVE_PERIOD) &&
+                    (App_baselineFlags == 0) && (App_trackedObjectsCount == 0))
+                App_saveProfile();
             break;
 
         default:
@@ -390,6 +1314,44 @@ void App_task(void)
     }
 }
 
+/* Time left until a deadline that started at start and lasts period, 0 once passed */
+static uint32_t App_timeLeft(uint32_t start, uint32_t period)
+{
+    uint32_t elapsed = millis() - start;
+    return (elapsed < period) ? (period - elapsed) : 0;
+}
+
+uint32_t App_getNextRunDelay(void)
+{
+    if (App_state != APP_WORKING)
+        return APP_CALIBRATION_PERIOD;
+
+    /* Distance replies wake the application up, a lost one is requested again on the next run */
+    uint32_t delay = PROXIMITY_SENSOR_TIMEOUT;
+
+    /* Objects under the color sensor are sampled every integration cycle,
+     * the capture time is decided on those samples */
+    uint32_t colorDelay = colorSensor.timeToDataReady();
+#if (COLOR_SENSOR_INTERRUPT_MODE == 1)
+    if (App_colorSensorIdle && !App_colorSensorInterrupt)
+        colorDelay = App_timeLeft(App_colorSensorLastReading, COLOR_BASELINE_PERIOD);
+#endif
+    if (colorDelay < delay)
+        delay = colorDelay;
+
+    /* An overdue save waits for an empty belt, runs taken anyway check for it */
+    uint32_t saveDelay = App_timeLeft(App_profileSaveTime, CALIB_PROFILE_SAVE_PERIOD);
+    if ((saveDelay > 0) && (saveDelay < delay))
+        delay = saveDelay;
+
+    return delay;
+}
+
+void App_setCaptureMode(t_AppCaptureMode mode)
+{
+    App_captureMode = mode;
+}
+
 void App_setObjectDetectionCallback(t_appObjectDetectionCallback callback)
 {
     App_objectDetectionCallback = callback;
@@ -405,7 +1367,35 @@ void App_setMotorCallback(t_appMotorCallback callback)
     App_motorCallback = callback;
 }
 
+void App_setWakeCallback(t_appWakeCallback callback)
+{
+    App_wakeCallback = callback;
+}
+
 bool App_getOverheightCondition(void)
 {
     return App_overheightCondition;
 }
+
+void App_getBeltEstimate(t_BeltEstimate * estimate)
+{
+    *estimate = App_beltEstimate;
+}
+
+bool App_getMotorCondition(void)
+{
+    return (!App_overheightCondition && !App_colorCaptureInProgress);
+}
+
+void App_getBaseline(t_AppBaseline * baseline)
+{
+    baseline->color = App_colorSensorBaseline;
+    baseline->clear = App_colorSensorClearBaseline;
+    baseline->distance = App_proximitySensorBaseline;
+    baseline->flags = App_baselineFlags;
+}
+
+void App_getStartupReport(t_AppStartupReport * report)
+{
+    *report = App_startupReport;
+}
@@ -9,17 +9,37 @@
 typedef enum
 {
     APP_INIT = 0,
+    APP_PROFILE_VALIDATE,
     APP_SENSOR_PREPARE,
     APP_WORKING
 } t_AppState;
 
+/* Object color capture mode
+ *
+ */
+typedef enum
+{
+    APP_CAPTURE_STOP_AND_READ = 0, /* Stop the motor for one long exposure */
+    APP_CAPTURE_FLYING             /* Keep the motor running, use short exposures */
+} t_AppCaptureMode;
+
+/* Live estimate of conveyor motion
+ *
+ */
+typedef struct
+{
+    uint16_t speed;        /* Belt speed in mm/s, 0 until a first measurement */
+    uint16_t objectLength; /* Length of last object in millimetres */
+    uint32_t transitTime;  /* Last measured travel time in milliseconds from proximity to color sensor */
+} t_BeltEstimate;
+
 /* Function prototype of a callback
  * for object detection
  *
- * input: pointer to a buffer that receives object color
+ * input: pointer to the object record, including its color
  * output: none
  */
-typedef void (* t_appObjectDetectionCallback)(t_Color * objectColor);
+typedef void (* t_appObjectDetectionCallback)(t_ObjectRecord * object);
 
 /* Set a callback function to be triggered
  * when an object is detected
@@ -62,6 +82,31 @@ typedef void (* t_appMotorCallback)(bool state);
  */
 void App_setMotorCallback(t_appMotorCallback callback);
 
+/* Function prototype of a callback for sensor events
+ * (color sensor interrupt, proximity sensor data received)
+ * so that App_task() can be run at once instead of polled
+ *
+ * input: true when called from interrupt context
+ */
+typedef void (* t_appWakeCallback)(bool fromIsr);
+
+/* Set a callback function to be triggered
+ * when a sensor needs attention
+ *
+ * input: pointer to callback function
+ *       (to unregister, pass a nullptr)
+ * output: none
+ */
+void App_setWakeCallback(t_appWakeCallback callback);
+
+/* Select how object color is captured,
+ * takes effect from the next detected object
+ *
+ * input: capture mode
+ * output: none
+ */
+void App_setCaptureMode(t_AppCaptureMode mode);
+
 /* Initialization procedure for application
  *
  * input: none
@@ -78,6 +123,14 @@ void App_init(void);
  */
 void App_task(void);
 
+/* Get the time App_task() can sleep unless a sensor
+ * event (see App_setWakeCallback) wakes it up sooner
+ *
+ * input: none
+ * output: milliseconds until the next deadline, 0 to run again at once
+ */
+uint32_t App_getNextRunDelay(void);
+
 /* Get status of overheight condition
  *
  * input: none
@@ -85,4 +138,61 @@ void App_task(void);
  */
 bool App_getOverheightCondition(void);
 
+/* Get the live estimate of conveyor motion
+ *
+ * input: pointer to a buffer that receives the estimate
+ * output: none
+ */
+void App_getBeltEstimate(t_BeltEstimate * estimate);
+
+/* Get permission for the motor to run,
+ * the motor must stay stopped on overheight
+ * and while an object color is being captured
+ *
+ * input: none
+ * output: true if the motor is allowed to run, false otherwise
+ */
+bool App_getMotorCondition(void);
+
+/* Baseline anomaly flags (bit mask), set while a tracked baseline
+ * is held at its drift limit around the calibrated value
+ */
+#define APP_BASELINE_COLOR_ANOMALY 0x01
+#define APP_BASELINE_PROXIMITY_ANOMALY 0x02
+
+/* Sensor readings with nothing in front of the sensors
+ *
+ */
+typedef struct
+{
+    t_Color color;     /* Normalized color of the empty belt */
+    uint16_t clear;    /* Raw clear channel of the empty belt */
+    uint16_t distance; /* Distance in millimetres to the belt */
+    uint8_t flags;     /* APP_BASELINE_xxx_ANOMALY */
+} t_AppBaseline;
+
+/* Get the baselines, tracked continuously while no object is present
+ *
+ * input: pointer to a buffer that receives the baselines
+ * output: none
+ */
+void App_getBaseline(t_AppBaseline * baseline);
+
+/* Startup timing, milliseconds since boot
+ *
+ */
+typedef struct
+{
+    bool profileRestored;        /* Baselines restored from saved profile, no calibration */
+    uint32_t readyTime;          /* Sensors ready, object detection started */
+    uint32_t firstDetectionTime; /* First object color reported, 0 until then */
+} t_AppStartupReport;
+
+/* Get startup timing
+ *
+ * input: pointer to a buffer that receives the report
+ * output: none
+ */
+void App_getStartupReport(t_AppStartupReport * report);
+
 #endif /* APPLICATION_H */
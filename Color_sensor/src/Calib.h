@@ -5,20 +5,87 @@
 #define COLOR_SENSOR_CALIB_CYCLES 3
 #define PROXIMITY_SENSOR_CALIB_CYCLES 15
 
-/* Detection threshold in color */
+/* Saved calibration profile: readings of each sensor to validate it at boot,
+ * and interval in milliseconds between saves of tracked baselines */
+#define CALIB_PROFILE_VALIDATION_CYCLES 2
+#define CALIB_PROFILE_SAVE_PERIOD 1800000
+
+/* Color difference tolerated when validating a saved calibration profile */
 #define COLOR_OBJECT_DETECTION_THRESHOLD 10
 
+/* Wake the color state machine from the sensor clear-channel interrupt (1) or poll it continuously (0) */
+#define COLOR_SENSOR_INTERRUPT_MODE 1
+
+/* Print every raw sensor reading on Serial (1) to record traces for the host replay test */
+#ifndef APP_TRACE_READINGS
+#define APP_TRACE_READINGS 0
+#endif
+
+/* Clear-channel interrupt window around the idle baseline, in percent of the baseline */
+#define COLOR_SENSOR_INTERRUPT_MARGIN 10
+
+/* Minimum clear-channel counts for an object color capture, the exposure
+ * controller picks the shortest integration time that reaches this level */
+#define COLOR_EXPOSURE_TARGET_CLEAR 2048
+
+/* Flying capture: maximum number of samples taken while the object passes under the sensor */
+#define COLOR_FLYING_CAPTURE_SAMPLES 12
+
+/* Flying capture: maximum spread (max - min) of a color channel within the stable plateau */
+#define COLOR_FLYING_PLATEAU_TOLERANCE 6
+
+/* Color classifier: largest distance (chromaticity units, 0-255) from a taught color
+ * to still be classified, and how much less intensity matters than chromaticity */
+#define COLOR_CLASS_MAX_DISTANCE 40
+#define COLOR_CLASS_INTENSITY_WEIGHT 4
+
+/* Baseline tracking while no object is present: weight of a new reading is 1/FILTER,
+ * baselines move at most MAX_STEP/256 unit per reading and stay within ANOMALY of calibration */
+#define COLOR_BASELINE_FILTER 64
+#define COLOR_BASELINE_MAX_STEP 16
+#define COLOR_BASELINE_ANOMALY 20         /* Normalized color counts */
+#define COLOR_BASELINE_CLEAR_ANOMALY 25   /* Percent of calibrated clear channel */
+#define PROXIMITY_BASELINE_FILTER 32
+#define PROXIMITY_BASELINE_MAX_STEP 32
+#define PROXIMITY_BASELINE_ANOMALY 50     /* Millimetres */
+
+/* Interval in milliseconds of color readings taken for baseline tracking while the sensor interrupt is quiet */
+#define COLOR_BASELINE_PERIOD 1000
+
 /* Overheight limit in millimetres from sensor to object top */
 #define OVERHEIGHT_LIMIT 30
 
 /* Overheight hysteresis (consecutive count that overheight condition is detected) */
 #define OVERHEIGHT_HYSTERESIS 3
 
-/* Color change hysteresis (consecutive count that color reading is different from baseline) */
-#define OBJECT_COLOR_DETECTION_HYSTERESIS 6
+/* Presence detection (sequential test): Q8 log-likelihood ratio that decides a state change
+ * (1177 = ln(99), 1% error rate), largest contribution of one reading, and shift in sigmas
+ * an object causes on a reading */
+#define PRESENCE_DECISION_THRESHOLD 1177
+#define PRESENCE_EVIDENCE_LIMIT 640
+#define PRESENCE_EXPECTED_SHIFT 3
+
+/* Presence detection: reading noise of empty belt (sigma) */
+#define PRESENCE_DISTANCE_SIGMA 8       /* Millimetres */
+#define PRESENCE_COLOR_SIGMA 3          /* Normalized color counts, largest channel difference */
+#define PRESENCE_CLEAR_SIGMA_PERCENT 3  /* Percent of clear channel baseline */
+
+/* Rolling median window (samples, 1-8) the detection decisions are taken on,
+ * a window of N rejects up to (N-1)/2 outlier readings */
+#define COLOR_MEDIAN_WINDOW 3
+#define PROXIMITY_MEDIAN_WINDOW 3
+
+/* Number of objects that can travel between proximity and color sensor at the same time */
+#define OBJECT_TRACKING_CAPACITY 8
+
+/* Time in milliseconds after which an object seen by distance but never by color is dropped */
+#define OBJECT_TRACKING_TIMEOUT 10000
+
+/* Distance in millimetres along the belt from proximity sensor to color sensor */
+#define SENSOR_SPACING 150
 
-/* Distance change hysteresis (consecutive count that distance reading is different from baseline) */
-#define OBJECT_DISTANCE_DETECTION_HYSTERESIS 6
+/* Belt speed estimation: weight of a new measurement is 1/BELT_SPEED_FILTER */
+#define BELT_SPEED_FILTER 4
 
 /* Maximum different between sensor readings when input remain unchanged */
 #define PROXIMITY_SENSOR_NOISE 16
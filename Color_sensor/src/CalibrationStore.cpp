@@ -0,0 +1,55 @@
+#include <Arduino.h>
+#include <Preferences.h>
+#include <rom/crc.h>
+
+#include "CalibrationStore.h"
+
+#define CALIBRATION_NAMESPACE "calibration"
+#define CALIBRATION_KEY "profile"
+
+/* Profile as stored, checksum covers the profile */
+typedef struct
+{
+    t_CalibrationProfile profile;
+    uint16_t crc;
+} t_StoredProfile;
+
+static uint16_t CalibrationStore_crc(const t_CalibrationProfile * profile)
+{
+    return crc16_le(0, (const uint8_t *)profile, sizeof(t_CalibrationProfile));
+}
+
+bool CalibrationStore_load(t_CalibrationProfile * profile)
+{
+    Preferences preferences;
+    t_StoredProfile stored;
+
+    if (!preferences.begin(CALIBRATION_NAMESPACE, true))
+        return false;
+
+    size_t length = preferences.getBytes(CALIBRATION_KEY, &stored, sizeof(stored));
+    preferences.end();
+
+    if ((length != sizeof(stored)) || (stored.crc != CalibrationStore_crc(&stored.profile)))
+        return false;
+
+    *profile = stored.profile;
+    return true;
+}
+
+bool CalibrationStore_save(const t_CalibrationProfile * profile)
+{
+    Preferences preferences;
+    t_StoredProfile stored;
+
+    stored.profile = *profile;
+    stored.crc = CalibrationStore_crc(&stored.profile);
+
+    if (!preferences.begin(CALIBRATION_NAMESPACE, false))
+        return false;
+
+    size_t length = preferences.putBytes(CALIBRATION_KEY, &stored, sizeof(stored));
+    preferences.end();
+
+    return (length == sizeof(stored));
+}
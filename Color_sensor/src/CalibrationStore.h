@@ -0,0 +1,31 @@
+#ifndef CALIBRATIONSTORE_H
+#define CALIBRATIONSTORE_H
+
+#include "Datatypes.h"
+
+/* Sensor baselines kept across reboots
+ *
+ */
+typedef struct
+{
+    uint32_t fingerprint; /* Sensor identity and settings the baselines were taken with */
+    t_Color color;        /* Normalized color of the empty belt */
+    uint16_t clear;       /* Raw clear channel of the empty belt */
+    uint16_t distance;    /* Distance in millimetres to the belt */
+} t_CalibrationProfile;
+
+/* Read last saved profile from NVS
+ *
+ * input: pointer to a buffer that receives the profile
+ * output: true if a profile with valid checksum was found, false otherwise
+ */
+bool CalibrationStore_load(t_CalibrationProfile * profile);
+
+/* Save a profile to NVS, replacing the previous one
+ *
+ * input: pointer to profile
+ * output: true for success, false otherwise
+ */
+bool CalibrationStore_save(const t_CalibrationProfile * profile);
+
+#endif /* CALIBRATIONSTORE_H */
@@ -0,0 +1,261 @@
+#include "ColorClassifier.h"
+#include "Calib.h"
+
+/* Feature space: chromaticity (red and green share of r+g+b, 0-255)
+ * and intensity ((r+g+b)/3, 0-255). Chromaticity ignores how much
+ * light reaches the object, intensity separates white, grey and black */
+
+/* Lookup table resolution: bits kept of each feature (32x32x8 cells, 16 KiB) */
+#define CLASSIFIER_CHROMA_BITS 5
+#define CLASSIFIER_INTENSITY_BITS 3
+
+#define CLASSIFIER_CHROMA_STEPS (1 << CLASSIFIER_CHROMA_BITS)
+#define CLASSIFIER_INTENSITY_STEPS (1 << CLASSIFIER_INTENSITY_BITS)
+#define CLASSIFIER_LUT_SIZE (CLASSIFIER_CHROMA_STEPS * CLASSIFIER_CHROMA_STEPS * CLASSIFIER_INTENSITY_STEPS)
+
+/* Table entry of a cell crossed by a class boundary, classified exactly */
+#define CLASSIFIER_BOUNDARY 0xFF
+
+typedef struct
+{
+    uint8_t red;       /* r / (r+g+b) */
+    uint8_t green;     /* g / (r+g+b) */
+    uint8_t intensity; /* (r+g+b) / 3 */
+} t_ColorFeature;
+
+typedef struct
+{
+    uint8_t classId;
+    uint8_t confidence;
+} t_ClassifierResult;
+
+/* Taught centroids, update after teaching the objects in use */
+static const t_ColorCentroid ColorClassifier_taught[] = {
+    {1, 200,  30,  25}, /* Red */
+    {2,  40, 160,  55}, /* Green */
+    {3,  30,  70, 155}, /* Blue */
+    {4, 140, 105,  10}, /* Yellow */
+    {5,  85,  85,  85}, /* White */
+    {6,  20,  20,  20}  /* Black */
+};
+
+static const t_ColorCentroid * ColorClassifier_centroids = ColorClassifier_taught;
+static uint8_t ColorClassifier_centroidCount = sizeof(ColorClassifier_taught) / sizeof(ColorClassifier_taught[0]);
+
+static t_ClassifierResult ColorClassifier_lut[CLASSIFIER_LUT_SIZE];
+
+static t_ColorFeature ColorClassifier_feature(uint8_t red, uint8_t green, uint8_t blue)
+{
+    uint16_t sum = red + green + blue;
+    t_ColorFeature feature = {85, 85, 0}; /* Black: neutral chromaticity */
+
+    if (sum > 0)
+    {
+        feature.red = (uint8_t)((red * 255U) / sum);
+        feature.green = (uint8_t)((green * 255U) / sum);
+        feature.intensity = (uint8_t)(sum / 3);
+    }
+
+    return feature;
+}
+
+/* Squared distance, intensity counts 1/COLOR_CLASS_INTENSITY_WEIGHT of chromaticity
+ * (chromaticity scaled up rather than intensity down, so nothing is truncated) */
+static uint32_t ColorClassifier_distance(const t_ColorFeature * a, const t_ColorFeature * b)
+{
+    int32_t dr = (int32_t)a->red - b->red;
+    int32_t dg = (int32_t)a->green - b->green;
+    int32_t di = (int32_t)a->intensity - b->intensity;
+
+    return (uint32_t)((((dr * dr) + (dg * dg)) * COLOR_CLASS_INTENSITY_WEIGHT) + (di * di));
+}
+
+#define CLASSIFIER_MAX_DISTANCE ((uint32_t)COLOR_CLASS_MAX_DISTANCE * COLOR_CLASS_MAX_DISTANCE * COLOR_CLASS_INTENSITY_WEIGHT)
+
+static t_ClassifierResult ColorClassifier_nearest(const t_ColorFeature * feature)
+{
+    uint32_t nearest = UINT32_MAX, second = UINT32_MAX;
+    t_ClassifierResult result = {COLOR_CLASS_NONE, 0};
+
+    for (uint8_t i = 0; i < ColorClassifier_centroidCount; i++)
+    {
+        const t_ColorCentroid * centroid = &ColorClassifier_centroids[i];
+        t_ColorFeature reference = ColorClassifier_feature(centroid->red, centroid->green, centroid->blue);
+        uint32_t distance = ColorClassifier_distance(feature, &reference);
+
+        if (distance < nearest)
+        {
+            second = nearest;
+            nearest = distance;
+            result.classId = centroid->classId;
+        }
+        else if (distance < second)
+            second = distance;
+    }
+
+    /* Too far from every taught color */
+    if (nearest > CLASSIFIER_MAX_DISTANCE)
+        return {COLOR_CLASS_NONE, 0};
+
+    /* Confidence: margin to the second nearest class, 255 when alone */
+    if (second == UINT32_MAX)
+        result.confidence = 255;
+    else if (second > 0)
+        result.confidence = (uint8_t)(((uint64_t)(second - nearest) * 255) / second);
+
+    return result;
+}
+
+static uint16_t ColorClassifier_lutIndex(const t_ColorFeature * feature)
+{
+    return (uint16_t)((((feature->intensity >> (8 - CLASSIFIER_INTENSITY_BITS)) * CLASSIFIER_CHROMA_STEPS) +
+            (feature->green >> (8 - CLASSIFIER_CHROMA_BITS))) * CLASSIFIER_CHROMA_STEPS +
+            (feature->red >> (8 - CLASSIFIER_CHROMA_BITS)));
+}
+
+static uint8_t ColorClassifier_clamp(uint8_t value, uint8_t low, uint8_t high)
+{
+    return (value < low) ? low : ((value > high) ? high : value);
+}
+
+/* Check that every color of a cell has the class of its center.
+ * Difference of the distances to two centroids is linear in the feature,
+ * so it keeps its sign over the cell if it does at the corners; distance
+ * to one centroid is convex, so the cell is within the limit if its corners are.
+ * The nearest centroid itself must be the same at the corners: with several
+ * centroids of one class, the nearest of them is not a linear function and
+ * another class can win inside a cell whose corners all have the same class
+ *
+ * input: cell bounds (inclusive), center of the cell, class of the center
+ * output: true if the whole cell has that class
+ */
+static bool ColorClassifier_uniformCell(const t_ColorFeature * low, const t_ColorFeature * high,
+        const t_ColorFeature * centerFeature, const t_ClassifierResult * center)
+{
+    if (center->classId == COLOR_CLASS_NONE)
+    {
+        /* Point of the cell nearest to each centroid is still too far */
+        for (uint8_t j = 0; j < ColorClassifier_centroidCount; j++)
+        {
+            const t_ColorCentroid * centroid = &ColorClassifier_centroids[j];
+            t_ColorFeature reference = ColorClassifier_feature(centroid->red, centroid->green, centroid->blue);
+            t_ColorFeature nearest = {
+                ColorClassifier_clamp(reference.red, low->red, high->red),
+                ColorClassifier_clamp(reference.green, low->green, high->green),
+                ColorClassifier_clamp(reference.intensity, low->intensity, high->intensity)
+            };
+
+            if (ColorClassifier_distance(&nearest, &reference) <= CLASSIFIER_MAX_DISTANCE)
+                return false;
+        }
+
+        return true;
+    }
+
+    /* Centroid nearest to the center, first one on a tie as in ColorClassifier_nearest() */
+    uint8_t own = 0;
+    uint32_t nearest = UINT32_MAX;
+    for (uint8_t j = 0; j < ColorClassifier_centroidCount; j++)
+    {
+        const t_ColorCentroid * centroid = &ColorClassifier_centroids[j];
+        t_ColorFeature reference = ColorClassifier_feature(centroid->red, centroid->green, centroid->blue);
+        uint32_t distance = ColorClassifier_distance(centerFeature, &reference);
+
+        if (distance < nearest)
+        {
+            nearest = distance;
+            own = j;
+        }
+    }
+
+    for (uint8_t corner = 0; corner < 8; corner++)
+    {
+        t_ColorFeature point = {
+            (corner & 0x01) ? high->red : low->red,
+            (corner & 0x02) ? high->green : low->green,
+            (corner & 0x04) ? high->intensity : low->intensity
+        };
+
+        /* The center's centroid is close enough and nearer than every other one, same class included */
+        uint32_t nearestOwn = UINT32_MAX, nearestOther = UINT32_MAX;
+        for (uint8_t j = 0; j < ColorClassifier_centroidCount; j++)
+        {
+            const t_ColorCentroid * centroid = &ColorClassifier_centroids[j];
+            t_ColorFeature reference = ColorClassifier_feature(centroid->red, centroid->green, centroid->blue);
+            uint32_t distance = ColorClassifier_distance(&point, &reference);
+
+            if (j == own)
+                nearestOwn = distance;
+            else
+                nearestOther = (distance < nearestOther) ? distance : nearestOther;
+        }
+
+        if ((nearestOwn > CLASSIFIER_MAX_DISTANCE) || (nearestOwn >= nearestOther))
+            return false;
+    }
+
+    return true;
+}
+
+static void ColorClassifier_buildLut(void)
+{
+    const uint8_t chromaStep = 256 / CLASSIFIER_CHROMA_STEPS;
+    const uint8_t intensityStep = 256 / CLASSIFIER_INTENSITY_STEPS;
+
+    /* Each cell takes the class of its center, cells crossed by a boundary are marked */
+    for (uint16_t i = 0; i < CLASSIFIER_INTENSITY_STEPS; i++)
+        for (uint16_t g = 0; g < CLASSIFIER_CHROMA_STEPS; g++)
+            for (uint16_t r = 0; r < CLASSIFIER_CHROMA_STEPS; r++)
+            {
+                t_ColorFeature low = {(uint8_t)(r * chromaStep), (uint8_t)(g * chromaStep), (uint8_t)(i * intensityStep)};
+                t_ColorFeature high = {
+                    (uint8_t)(low.red + chromaStep - 1),
+                    (uint8_t)(low.green + chromaStep - 1),
+                    (uint8_t)(low.intensity + intensityStep - 1)
+                };
+                t_ColorFeature center = {
+                    (uint8_t)(low.red + (chromaStep / 2)),
+                    (uint8_t)(low.green + (chromaStep / 2)),
+                    (uint8_t)(low.intensity + (intensityStep / 2))
+                };
+
+                t_ClassifierResult result = ColorClassifier_nearest(&center);
+                if (!ColorClassifier_uniformCell(&low, &high, &center, &result))
+                    result.classId = CLASSIFIER_BOUNDARY;
+
+                ColorClassifier_lut[ColorClassifier_lutIndex(&center)] = result;
+            }
+}
+
+void ColorClassifier_init(void)
+{
+    ColorClassifier_buildLut();
+}
+
+void ColorClassifier_setCentroids(const t_ColorCentroid * centroids, uint8_t count)
+{
+    ColorClassifier_centroids = centroids;
+    ColorClassifier_centroidCount = count;
+    ColorClassifier_buildLut();
+}
+
+void ColorClassifier_classify(t_Color * color)
+{
+    t_ColorFeature feature = ColorClassifier_feature(color->red, color->green, color->blue);
+    t_ClassifierResult result = ColorClassifier_lut[ColorClassifier_lutIndex(&feature)];
+
+    if (result.classId == CLASSIFIER_BOUNDARY)
+        result = ColorClassifier_nearest(&feature);
+
+    color->classId = result.classId;
+    color->confidence = result.confidence;
+}
+
+void ColorClassifier_classifyExact(t_Color * color)
+{
+    t_ColorFeature feature = ColorClassifier_feature(color->red, color->green, color->blue);
+    t_ClassifierResult result = ColorClassifier_nearest(&feature);
+
+    color->classId = result.classId;
+    color->confidence = result.confidence;
+}
@@ -0,0 +1,51 @@
+#ifndef COLORCLASSIFIER_H
+#define COLORCLASSIFIER_H
+
+#include "Datatypes.h"
+
+/* Taught color of a class, in the same scale as reported object colors
+ *
+ */
+typedef struct
+{
+    uint8_t classId; /* 1 to COLOR_CLASS_COUNT - 1 */
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+} t_ColorCentroid;
+
+/* Build lookup table from the taught centroids kept in flash
+ *
+ * input: none
+ * output: none
+ */
+void ColorClassifier_init(void);
+
+/* Replace taught centroids and rebuild lookup table,
+ * several centroids may share a class
+ *
+ * input: pointer to centroids (must stay valid), number of centroids
+ * output: none
+ */
+void ColorClassifier_setCentroids(const t_ColorCentroid * centroids, uint8_t count);
+
+/* Classify a color with one table lookup, or exactly if its table cell
+ * is crossed by a class boundary, so classId always matches
+ * ColorClassifier_classifyExact(); confidence is that of the cell center
+ * away from boundaries. Sets classId (COLOR_CLASS_NONE if no centroid
+ * is close enough) and confidence
+ *
+ * input: pointer to color
+ * output: none
+ */
+void ColorClassifier_classify(t_Color * color);
+
+/* Classify a color by computing the distance to every centroid,
+ * reference for the lookup table (slower, not quantized)
+ *
+ * input: pointer to color
+ * output: none
+ */
+void ColorClassifier_classifyExact(t_Color * color);
+
+#endif /* COLORCLASSIFIER_H */
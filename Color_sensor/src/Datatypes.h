@@ -1,12 +1,32 @@
 #ifndef DATATYPES_H
 #define DATATYPES_H
 
+#include <stdint.h>
+#include "RecordKey.h"
+
 typedef struct
 {
     uint8_t red;
     uint8_t green;
     uint8_t blue;
-    uint8_t clear;
+    uint16_t clear;     /* Raw clear channel count of the capture, at preview exposure (24 ms, 4x) */
+    uint8_t classId;    /* Color class, COLOR_CLASS_NONE if not classified */
+    uint8_t confidence; /* Classification confidence, 0 (none) to 255 */
 } t_Color;
 
+#define COLOR_CLASS_NONE 0
+#define COLOR_CLASS_COUNT 16 /* Class ids range from 0 to COLOR_CLASS_COUNT - 1 */
+
+typedef struct
+{
+    uint32_t sequence;  /* Object number since boot */
+    uint32_t timestamp; /* millis() when the object front reached the proximity sensor */
+    uint32_t dwell;     /* Time in milliseconds the object took to pass the proximity sensor with the belt running, 0 while unknown */
+    uint16_t height;    /* Object height in millimetres above the belt */
+    uint32_t epoch;     /* Wall-clock seconds of detection, set when queued for upload */
+    uint16_t epochMs;   /* Millisecond part of wall-clock time of detection */
+    char key[RECORD_KEY_LENGTH + 1]; /* Database key, set once when queued so retries overwrite the same node */
+    t_Color color;
+} t_ObjectRecord;
+
 #endif /* DATATYPES_H */
@@ -0,0 +1,64 @@
+#include "DetectionQueue.h"
+
+static_assert((DETECTION_QUEUE_SIZE & (DETECTION_QUEUE_SIZE - 1)) == 0, "DETECTION_QUEUE_SIZE must be a power of two");
+
+void DetectionQueue_init(t_DetectionQueue * queue)
+{
+    queue->head.store(0, std::memory_order_relaxed);
+    queue->tail.store(0, std::memory_order_relaxed);
+}
+
+bool DetectionQueue_push(t_DetectionQueue * queue, const t_ObjectRecord * record)
+{
+    uint32_t tail = queue->tail.load(std::memory_order_relaxed);
+
+    /* Acquire: the consumer is done with the slot it released */
+    if ((tail - queue->head.load(std::memory_order_acquire)) >= DETECTION_QUEUE_SIZE)
+        return false;
+
+    queue->buffer[tail % DETECTION_QUEUE_SIZE] = *record;
+
+    /* Release: the record is visible before the new tail */
+    queue->tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool DetectionQueue_pop(t_DetectionQueue * queue, t_ObjectRecord * record)
+{
+    uint32_t head = queue->head.load(std::memory_order_relaxed);
+
+    /* Acquire: the record written by the producer is visible */
+    if (head == queue->tail.load(std::memory_order_acquire))
+        return false;
+
+    *record = queue->buffer[head % DETECTION_QUEUE_SIZE];
+
+    /* Release: the slot is free only after the copy */
+    queue->head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+const t_ObjectRecord * DetectionQueue_peek(t_DetectionQueue * queue)
+{
+    uint32_t head = queue->head.load(std::memory_order_relaxed);
+
+    if (head == queue->tail.load(std::memory_order_acquire))
+        return nullptr;
+
+    return &queue->buffer[head % DETECTION_QUEUE_SIZE];
+}
+
+const t_ObjectRecord * DetectionQueue_peekAt(t_DetectionQueue * queue, uint32_t index)
+{
+    uint32_t head = queue->head.load(std::memory_order_relaxed);
+
+    if (index >= (queue->tail.load(std::memory_order_acquire) - head))
+        return nullptr;
+
+    return &queue->buffer[(head + index) % DETECTION_QUEUE_SIZE];
+}
+
+uint32_t DetectionQueue_count(t_DetectionQueue * queue)
+{
+    return queue->tail.load(std::memory_order_acquire) - queue->head.load(std::memory_order_acquire);
+}
@@ -0,0 +1,66 @@
+#ifndef DETECTIONQUEUE_H
+#define DETECTIONQUEUE_H
+
+#include <atomic>
+#include "Datatypes.h"
+
+/* Number of records a queue can hold (power of two) */
+#define DETECTION_QUEUE_SIZE 16
+
+/* Lock-free single-producer/single-consumer ring of object records.
+ * One task may push while another one pops, without any lock.
+ * Indexes run freely, slot = index % DETECTION_QUEUE_SIZE
+ */
+typedef struct
+{
+    t_ObjectRecord buffer[DETECTION_QUEUE_SIZE];
+    std::atomic<uint32_t> head; /* Next record to pop, written by consumer only */
+    std::atomic<uint32_t> tail; /* Next free slot, written by producer only */
+} t_DetectionQueue;
+
+/* Reset a queue to empty state,
+ * must not race with push or pop
+ *
+ * input: pointer to queue
+ * output: none
+ */
+void DetectionQueue_init(t_DetectionQueue * queue);
+
+/* Append a record (producer side)
+ *
+ * input: pointer to queue, pointer to record to be copied
+ * output: true for success, false if the queue is full
+ */
+bool DetectionQueue_push(t_DetectionQueue * queue, const t_ObjectRecord * record);
+
+/* Remove the oldest record (consumer side)
+ *
+ * input: pointer to queue, pointer to a buffer that receives the record
+ * output: true for success, false if the queue is empty
+ */
+bool DetectionQueue_pop(t_DetectionQueue * queue, t_ObjectRecord * record);
+
+/* Read the oldest record without removing it (consumer side)
+ *
+ * input: pointer to queue
+ * output: pointer to the record, nullptr if the queue is empty
+ */
+const t_ObjectRecord * DetectionQueue_peek(t_DetectionQueue * queue);
+
+/* Read a waiting record without removing it (consumer side),
+ * index 0 is the oldest one
+ *
+ * input: pointer to queue, position from the oldest record
+ * output: pointer to the record, nullptr if fewer records are waiting
+ */
+const t_ObjectRecord * DetectionQueue_peekAt(t_DetectionQueue * queue, uint32_t index);
+
+/* Get number of records waiting in a queue,
+ * exact only when called from producer or consumer
+ *
+ * input: pointer to queue
+ * output: number of records
+ */
+uint32_t DetectionQueue_count(t_DetectionQueue * queue);
+
+#endif /* DETECTIONQUEUE_H */
@@ -1,5 +1,4 @@
 #include <Arduino.h>
-#include "Time.h"
 
 #include "Lib/Firebase_ESP32_Client/src/FirebaseESP32.h"
 // Provide the token generation process info.
@@ -8,67 +7,104 @@
 #include "Lib/Firebase_ESP32_Client/src/addons/RTDBHelper.h"
 
 #include "FirebaseDb.h"
+#include "DetectionQueue.h"
+#include "Journal.h"
+#include "RecordKey.h"
+#include "TimeService.h"
+#include "Metrics.h"
 #include "Authen.h"
 
-// Firebase Data object
-static FirebaseData fbdo;
-static FirebaseAuth auth;
-static FirebaseConfig config;
-static FirebaseJson json;
+/* Upload retry policy: attempts per record and backoff between them (ms) */
+#define DATABASE_UPLOAD_ATTEMPTS 5
+#define DATABASE_RETRY_BACKOFF_MIN 500
+#define DATABASE_RETRY_BACKOFF_MAX 30000
 
-// Variable to save USER UID
-static String uid;
+/* Upload batching: records per request, and longest wait for a batch to fill (ms) */
+#define DATABASE_UPLOAD_BATCH 8
+#define DATABASE_BATCH_WAIT 1000
 
-// Database child nodes
-static const String colorPath = "/color";
-static const String timePath = "/timestamp";
-static const String userPath = "/user";
-static const String statusPath = "/status";
-static const String databasePath = "/Data";
+/* Serialized batch size, fits DATABASE_UPLOAD_BATCH records of DATABASE_LEGACY_FORMAT */
+#define DATABASE_UPLOAD_BUFFER 1024
 
-// Parent Node (to be updated before pushing)
-static String parentPath;
+/* Record fields, as children of /Data/<key> */
+#define DATABASE_LEGACY_FORMAT "\"%s\":{\"user\":\"\",\"status\":\"0\",\"color\":\"%u,%u,%u\",\"timestamp\":\"%s\"}"
+#define DATABASE_COMPACT_FORMAT "\"%s\":{\"r\":%u,\"g\":%u,\"b\":%u,\"c\":%u,\"t\":%s%s}"
+#define DATABASE_SERVER_TIMESTAMP "{\".sv\":\"timestamp\"}"
 
-static t_FirebaseState Firebase_state = FIREBASE_INIT;
+/* Aggregation: bucket length (s), buckets kept while not flushed,
+ * delay after end of bucket for late records (s), retry interval of failed flush (ms) */
+#define DATABASE_AGGREGATE_PERIOD 60
+#define DATABASE_AGGREGATE_BUCKETS 8
+#define DATABASE_AGGREGATE_GRACE 5
+#define DATABASE_AGGREGATE_RETRY 5000
 
-static void Database_configLocalTime(void)
-{
-    const char * ntpServer = "pool.ntp.org";
+/* Histogram members: absolute counts under the flush key of the bucket,
+ * so a retry after an ambiguous failure overwrites instead of adding twice */
+#define DATABASE_COUNT_FORMAT "\"%s\":%u"
 
-    /* GMT+7 offset in seconds */
-    const long GMT7_sec = 7 * 60 * 60;
+/* Records read from the flash journal and uploaded as one batch */
+#define DATABASE_REPLAY_BATCH 8
 
-    configTime(GMT7_sec, 0, ntpServer);
-    Serial.println("Time sync, GMT+7 (Hanoi)");
-}
+/* Live batches sent in a row while a journal batch waits, so the
+ * journal keeps a share of the requests under a steady detection rate */
+#define DATABASE_LIVE_BATCHES_PER_REPLAY 3
 
-static void Database_getLocalTime(struct tm * localTime)
-{
-    struct tm * info;
+/* Interval of stage latency uploads to /metrics (ms) */
+#define DATABASE_METRICS_PERIOD 60000
 
-    /* Dummy object used in case function only needs to show local time */
-    struct tm dummy;
+// Firebase Data object
+static FirebaseData fbdo;
+static FirebaseAuth auth;
+static FirebaseConfig config;
 
-    if (localTime == nullptr) /* Show only, no return */
-        info = &dummy;
-    else /* Return local time to a desired address */
-        info = localTime;
+// Variable to save USER UID
+static String uid;
 
-    (void)getLocalTime(info);
+// Database node of object records and of histograms
+static const char * databasePath = "/Data";
+static const char * countsPath = "/Counts";
+#if METRICS_ENABLE
+static const char * metricsPath = "/metrics";
+static uint32_t metricsNextUpload = DATABASE_METRICS_PERIOD;
+#endif
 
-    if (localTime == nullptr) /* Display result */
-    {
-        int16_t yy = (info->tm_year) + 1900;
-        Serial.printf("Local date: %d/%d/%d\n", info->tm_mday, (info->tm_mon) + 1, yy);
-        Serial.printf("Local time: %d:%d:%d\n", info->tm_hour, info->tm_min, info->tm_sec);
-    }
-}
+static t_FirebaseState Firebase_state = FIREBASE_INIT;
+
+// Upload queue, filled by Database_enqueueObject(), drained by Database_task()
+static t_DetectionQueue uploadQueue;
+static t_DatabaseStats uploadStats = {0, 0, 0, 0, 0, 0};
+static uint8_t uploadAttempts = 0;
+static uint32_t uploadBackoff = DATABASE_RETRY_BACKOFF_MIN;
+static uint32_t uploadNextAttempt = 0;
+static char uploadBuffer[DATABASE_UPLOAD_BUFFER];
+static t_DatabaseSchema uploadSchema = DATABASE_SCHEMA_LEGACY;
+static uint8_t uploadMode = DATABASE_UPLOAD_RAW;
+
+// Object count per color class over one period, start = 0 for a free bucket,
+// flushKey set on first flush attempt and kept until the flush succeeded
+typedef struct
+{
+    uint32_t start;
+    char flushKey[RECORD_KEY_LENGTH + 1];
+    uint16_t total;
+    uint16_t counts[COLOR_CLASS_COUNT];
+} t_AggregateBucket;
+
+static t_AggregateBucket aggregateBuckets[DATABASE_AGGREGATE_BUCKETS];
+static uint32_t aggregateNextAttempt = 0;
+
+// Offline journal, records read for replay and not uploaded yet (cursor committed once they are done)
+static bool journalReady = false;
+static t_ObjectRecord replayBatch[DATABASE_REPLAY_BATCH];
+static uint16_t replayCount = 0;
+static uint8_t liveBatchesInRow = 0;
+static bool uploadReplaying = false; /* Batch being retried comes from the journal */
 
 static void Database_init(void)
 {
     if (Firebase_state != FIREBASE_INIT) return;
 
-    Database_configLocalTime();
+    TimeService_init();
 
     // Assign the api key (required)
     config.api_key = API_KEY;
@@ -95,27 +131,397 @@ static void Database_init(void)
     Firebase_state = FIREBASE_CONNECTING;
 }
 
+static void Database_openJournal(void)
+{
+    if (journalReady) return;
+
+    journalReady = Journal_init(&Journal_flashStorage);
+    if (journalReady && Journal_pending())
+        Serial.println("Journal: records waiting for upload");
+}
+
+/* Serialize an object record as one member of a multi-location update,
+ * straight into the caller's buffer (the client still copies the whole
+ * batch into its request string, one allocation per request)
+ *
+ * output: number of characters written, 0 if the buffer is too small
+ */
+static size_t Database_serializeObject(char * buffer, size_t size, const t_ObjectRecord * object)
+{
+    const t_Color * color = &object->color;
+    int length;
+
+    /* Child of /Data, one entry per object, same key on every retry or replay.
+     * Time of detection, not of upload, unless the server stamps it */
+    if (uploadSchema == DATABASE_SCHEMA_LEGACY)
+    {
+        length = snprintf(buffer, size, DATABASE_LEGACY_FORMAT, object->key,
+                color->red, color->green, color->blue, TimeService_formatDate(object->epoch));
+    }
+    else
+    {
+        char time[24];
+        char classId[12] = "";
+
+        if (uploadSchema == DATABASE_SCHEMA_COMPACT_SERVER)
+            snprintf(time, sizeof(time), "%s", DATABASE_SERVER_TIMESTAMP);
+        else
+            snprintf(time, sizeof(time), "%llu", ((unsigned long long)object->epoch * 1000) + object->epochMs);
+
+        if (color->classId != COLOR_CLASS_NONE)
+            snprintf(classId, sizeof(classId), ",\"k\":%u", color->classId);
+
+        length = snprintf(buffer, size, DATABASE_COMPACT_FORMAT, object->key,
+                color->red, color->green, color->blue, color->clear, time, classId);
+    }
+
+    if ((length < 0) || ((size_t)length >= size))
+        return 0;
+
+    return (size_t)length;
+}
+
+/* Serialize records as one JSON object
+ *
+ * input: records, number of records
+ * output: number of records serialized
+ */
+static uint32_t Database_serializeBatch(const t_ObjectRecord * const * records, uint32_t count)
+{
+    size_t length = 1;
+    uint32_t serialized = 0;
+
+    uploadBuffer[0] = '{';
+
+    for (; serialized < count; serialized++)
+    {
+        /* Room for separator and closing brace */
+        char * member = &uploadBuffer[length + ((serialized > 0) ? 1 : 0)];
+        size_t room = sizeof(uploadBuffer) - (member - uploadBuffer) - 1;
+
+        size_t written = Database_serializeObject(member, room, records[serialized]);
+        if (written == 0)
+            break; /* Buffer full, remaining records go with next batch */
+
+        if (serialized > 0)
+            uploadBuffer[length] = ',';
+        length = (member - uploadBuffer) + written;
+    }
+
+    uploadBuffer[length++] = '}';
+    uploadBuffer[length] = '\0';
+    return serialized;
+}
+
+/* Number of queued records ready to be sent as one batch,
+ * 0 while the batch is still filling up
+ */
+static uint32_t Database_batchSize(void)
+{
+    const t_ObjectRecord * oldest = DetectionQueue_peek(&uploadQueue);
+    if (oldest == nullptr)
+        return 0;
+
+    uint32_t count = DetectionQueue_count(&uploadQueue);
+    if (count >= DATABASE_UPLOAD_BATCH)
+        return DATABASE_UPLOAD_BATCH;
+
+    /* Not full yet: wait for more unless the oldest record is waiting long enough */
+    if ((millis() - oldest->timestamp) < DATABASE_BATCH_WAIT)
+        return 0;
+
+    return count;
+}
+
+/* Push the oldest queued records, or the records read from the
+ * journal when it is their turn, as one multi-location update
+ * when their retry time has come, one request per call to keep
+ * Database_task() short. The update is atomic: all records of
+ * the batch succeed or fail together
+ */
+static void Database_uploadQueued(void)
+{
+    if ((int32_t)(millis() - uploadNextAttempt) < 0)
+        return; /* Backing off */
+
+    /* A batch being retried keeps its turn, otherwise the journal
+     * waits at most DATABASE_LIVE_BATCHES_PER_REPLAY live batches */
+    uint32_t liveCount = Database_batchSize();
+    bool replaying;
+    if (uploadAttempts > 0)
+        replaying = uploadReplaying;
+    else
+        replaying = (replayCount > 0) && ((liveCount == 0) || (liveBatchesInRow >= DATABASE_LIVE_BATCHES_PER_REPLAY));
+
+    const t_ObjectRecord * records[DATABASE_UPLOAD_BATCH];
+    uint32_t count = replaying ? replayCount : liveCount;
+    if (count > DATABASE_UPLOAD_BATCH)
+        count = DATABASE_UPLOAD_BATCH;
+
+    for (uint32_t i = 0; i < count; i++)
+        records[i] = replaying ? &replayBatch[i] : DetectionQueue_peekAt(&uploadQueue, i);
+
+    count = Database_serializeBatch(records, count);
+    if (count == 0)
+        return;
+
+    METRICS_START(pushStart);
+    bool sent = Firebase.RTDB.updateNodeSilentRaw(&fbdo, databasePath, uploadBuffer);
+    METRICS_STOP(METRICS_FIREBASE_PUSH, pushStart);
+
+    if (!sent && (++uploadAttempts < DATABASE_UPLOAD_ATTEMPTS))
+    {
+        uploadReplaying = replaying;
+        uploadStats.retried += count;
+        uploadNextAttempt = millis() + uploadBackoff;
+        Serial.printf("Push failed (%s), retry in %u ms\n", fbdo.errorReason().c_str(), uploadBackoff);
+
+        uploadBackoff *= 2;
+        if (uploadBackoff > DATABASE_RETRY_BACKOFF_MAX)
+            uploadBackoff = DATABASE_RETRY_BACKOFF_MAX;
+        return;
+    }
+
+    /* Batch done (sent or given up), report each record, next batch starts fresh.
+     * On failure replayed records stay in the journal (not committed),
+     * live records are journaled */
+    for (uint32_t i = 0; i < count; i++)
+    {
+        t_ObjectRecord record;
+        if (replaying)
+            record = replayBatch[i];
+        else
+            (void)DetectionQueue_pop(&uploadQueue, &record);
+
+        const char * result = "OK";
+        if (sent)
+            uploadStats.sent++;
+        else if (replaying)
+            result = "kept in journal";
+        else
+        {
+            Database_openJournal();
+            if (journalReady && Journal_append(&record))
+            {
+                uploadStats.journaled++;
+                result = "journaled";
+            }
+            else
+            {
+                uploadStats.dropped++;
+                result = "dropped";
+            }
+        }
+
+        Serial.printf("Db push #%u (%d,%d,%d): %s\n", record.sequence, record.color.red, record.color.green, record.color.blue, result);
+    }
+
+    uploadAttempts = 0;
+    uploadBackoff = DATABASE_RETRY_BACKOFF_MIN;
+    uploadNextAttempt = sent ? millis() : (millis() + DATABASE_RETRY_BACKOFF_MAX);
+
+    if (!replaying)
+    {
+        liveBatchesInRow++;
+        return;
+    }
+
+    liveBatchesInRow = 0;
+
+    /* Given up: the replay starts over from the journal cursor later */
+    if (!sent)
+    {
+        replayCount = 0;
+        return;
+    }
+
+    /* Records the buffer had no room for go with the next batch,
+     * the journal cursor moves once the whole batch is sent */
+    replayCount -= count;
+    for (uint16_t i = 0; i < replayCount; i++)
+        replayBatch[i] = replayBatch[count + i];
+
+    if (replayCount == 0)
+        Journal_commit();
+}
+
+/* Count an object in the histogram of its period */
+static void Database_aggregateObject(const t_ObjectRecord * object)
+{
+    uint32_t start = object->epoch - (object->epoch % DATABASE_AGGREGATE_PERIOD);
+    t_AggregateBucket * bucket = nullptr;
+    t_AggregateBucket * oldest = &aggregateBuckets[0];
+
+    for (uint8_t i = 0; i < DATABASE_AGGREGATE_BUCKETS; i++)
+    {
+        if (aggregateBuckets[i].start == start)
+        {
+            bucket = &aggregateBuckets[i];
+            break;
+        }
+
+        if (aggregateBuckets[i].start < oldest->start)
+            oldest = &aggregateBuckets[i];
+    }
+
+    if (bucket == nullptr)
+    {
+        /* No free bucket (offline too long): the oldest one is lost */
+        if (oldest->start != 0)
+            uploadStats.dropped += oldest->total;
+
+        memset(oldest, 0, sizeof(t_AggregateBucket));
+        oldest->start = start;
+        bucket = oldest;
+    }
+
+    uint8_t classId = (object->color.classId < COLOR_CLASS_COUNT) ? object->color.classId : COLOR_CLASS_NONE;
+    bucket->counts[classId]++;
+    bucket->total++;
+    uploadStats.counted++;
+}
+
+/* Flush one histogram whose period is over, as /Counts/<start>/<flushKey>/<class>
+ * and /Counts/<start>/<flushKey>/n. The key is unique per device and boot and the
+ * same for every attempt, so retries are idempotent; objects counted after a flush
+ * of the period go to a new key, the total of a period is the sum of its keys
+ *
+ * output: true if a request was made
+ */
+static bool Database_flushAggregates(void)
+{
+    if ((int32_t)(millis() - aggregateNextAttempt) < 0)
+        return false;
+
+    uint32_t now = (uint32_t)(TimeService_nowMs() / 1000);
+    t_AggregateBucket * bucket = nullptr;
+
+    for (uint8_t i = 0; i < DATABASE_AGGREGATE_BUCKETS; i++)
+    {
+        t_AggregateBucket * candidate = &aggregateBuckets[i];
+        if ((candidate->start != 0) && (now >= (candidate->start + DATABASE_AGGREGATE_PERIOD + DATABASE_AGGREGATE_GRACE)) &&
+                ((bucket == nullptr) || (candidate->start < bucket->start)))
+            bucket = candidate;
+    }
+
+    if (bucket == nullptr)
+        return false;
+
+    if (bucket->flushKey[0] == '\0')
+        RecordKey_generate(TimeService_nowMs(), bucket->flushKey);
+
+    char path[24];
+    char member[24];
+    size_t length = 0;
+
+    snprintf(path, sizeof(path), "%s/%lu", countsPath, (unsigned long)bucket->start);
+
+    snprintf(member, sizeof(member), DATABASE_COUNT_FORMAT, "n", bucket->total);
+    length += snprintf(&uploadBuffer[length], sizeof(uploadBuffer) - length, "{\"%s\":{%s", bucket->flushKey, member);
+
+    for (uint8_t classId = 0; classId < COLOR_CLASS_COUNT; classId++)
+    {
+        if (bucket->counts[classId] == 0)
+            continue;
+
+        char name[4];
+        snprintf(name, sizeof(name), "%u", classId);
+        snprintf(member, sizeof(member), DATABASE_COUNT_FORMAT, name, bucket->counts[classId]);
+        length += snprintf(&uploadBuffer[length], sizeof(uploadBuffer) - length, ",%s", member);
+    }
+
+    snprintf(&uploadBuffer[length], sizeof(uploadBuffer) - length, "}}");
+
+    METRICS_START(pushStart);
+    bool sent = Firebase.RTDB.updateNodeSilentRaw(&fbdo, path, uploadBuffer);
+    METRICS_STOP(METRICS_FIREBASE_PUSH, pushStart);
+
+    if (sent)
+    {
+        Serial.printf("Db counts %s/%s: %u objects\n", path, bucket->flushKey, bucket->total);
+        memset(bucket, 0, sizeof(t_AggregateBucket));
+    }
+    else
+    {
+        Serial.printf("Db counts %s failed (%s)\n", path, fbdo.errorReason().c_str());
+        aggregateNextAttempt = millis() + DATABASE_AGGREGATE_RETRY;
+    }
+
+    return true;
+}
+
+#if METRICS_ENABLE
+/* Overwrite /metrics with stage latencies since boot when the period is over
+ *
+ * output: true if a request was made
+ */
+static bool Database_uploadMetrics(void)
+{
+    if ((int32_t)(millis() - metricsNextUpload) < 0)
+        return false;
+
+    metricsNextUpload = millis() + DATABASE_METRICS_PERIOD;
+
+    if (Metrics_serialize(uploadBuffer, sizeof(uploadBuffer)) == 0)
+        return false;
+
+    if (!Firebase.RTDB.updateNodeSilentRaw(&fbdo, metricsPath, uploadBuffer))
+        Serial.printf("Db metrics failed (%s)\n", fbdo.errorReason().c_str());
+
+    return true;
+}
+#endif
+
+/* Read the next batch of journaled records once the previous one is done,
+ * Database_uploadQueued() sends it in turn with live batches
+ */
+static void Database_replayJournal(void)
+{
+    if (!journalReady || (replayCount > 0))
+        return;
+
+    uint16_t count = Journal_read(replayBatch, DATABASE_REPLAY_BATCH);
+
+    if (count > 0)
+    {
+        replayCount = count;
+        Serial.printf("Journal: replay %u records\n", count);
+    }
+    else if (Journal_pending())
+        Journal_commit(); /* Only corrupted entries left, skip them */
+}
+
 void Database_task(void)
 {
     switch (Firebase_state)
     {
         case FIREBASE_INIT:
             Database_init();
+            Database_openJournal();
             break;
 
         case FIREBASE_CONNECTING:
-            if (Firebase.ready())
+        {
+            METRICS_START(readyStart);
+            bool db_ready = Firebase.ready();
+            METRICS_STOP(METRICS_FIREBASE_READY, readyStart);
+
+            if (db_ready)
             {
                 Firebase_state = FIREBASE_CONNECTED;
                 Serial.println("Db authen OK");
-                Database_getLocalTime(nullptr); /* Show local time */
+                if (TimeService_isSynced()) /* Show local time */
+                    Serial.printf("Local time: %s\n", TimeService_formatDate((uint32_t)(TimeService_nowMs() / 1000)));
             }
             break;
+        }
 
         case FIREBASE_CONNECTED:
         {
             /* Periodically call Firebase.ready() to handle authentication */
+            METRICS_START(readyStart);
             bool db_ready = Firebase.ready();
+            METRICS_STOP(METRICS_FIREBASE_READY, readyStart);
 
             /* Check if token is still valid */
             db_ready &= !Firebase.isTokenExpired(); /* Bit-wise AND applicable here as both functions return boolean type */
@@ -124,7 +530,20 @@ void Database_task(void)
             {
                 Firebase_state = FIREBASE_CONNECTING;
                 Serial.println("Db reconnecting");
+                break;
             }
+
+            /* One request per call, histograms first as they are few */
+            if (Database_flushAggregates())
+                break;
+
+#if METRICS_ENABLE
+            if (Database_uploadMetrics())
+                break;
+#endif
+
+            Database_replayJournal();
+            Database_uploadQueued();
             break;
         }
 
@@ -148,32 +567,54 @@ t_FirebaseState Database_getState(void)
     return Firebase_state;
 }
 
-bool Database_pushObjectColor(t_Color * objectColor)
+bool Database_enqueueObject(const t_ObjectRecord * object)
 {
-    String objectColorValue = String(objectColor->red) + "," + String(objectColor->green) + "," + String(objectColor->blue);
+    t_ObjectRecord record = *object;
 
-    struct tm timeStamp;
-    Database_getLocalTime(&timeStamp);
+    /* Stamp wall-clock time of detection, the record may wait in queue */
+    uint64_t detectionMs = TimeService_epochMsAt(object->timestamp);
 
-    String hh = (timeStamp.tm_hour < 10 ? "0" : "") + String(timeStamp.tm_hour);
-    String mm = (timeStamp.tm_min < 10 ? "0" : "") + String(timeStamp.tm_min);
-    String ss = (timeStamp.tm_sec < 10 ? "0" : "") + String(timeStamp.tm_sec);
+    record.epoch = (uint32_t)(detectionMs / 1000);
+    record.epochMs = (uint16_t)(detectionMs % 1000);
+    RecordKey_generate(detectionMs, record.key);
 
-    String objectDetectionTime = String(timeStamp.tm_mday) + "/" + String((timeStamp.tm_mon) + 1) + "/" + String((timeStamp.tm_year) + 1900) +
-            " " + hh + ":" + mm + ":" + ss;
+    if (uploadMode & DATABASE_UPLOAD_AGGREGATE)
+        Database_aggregateObject(&record);
 
-    /* Get epoch time */
-    time_t now;
-    time(&now);
+    if (!(uploadMode & DATABASE_UPLOAD_RAW))
+        return true;
 
-    Serial.printf("Db push: (%d,%d,%d)\n",objectColor->red, objectColor->green, objectColor->blue);
+    /* Online: straight to the upload queue */
+    if ((Firebase_state == FIREBASE_CONNECTED) && DetectionQueue_push(&uploadQueue, &record))
+    {
+        uploadStats.queued++;
+        return true;
+    }
 
-    parentPath = databasePath + "/" + String(now);
+    /* Offline or queue full: keep it on flash until the connection is back */
+    Database_openJournal();
+    if (journalReady && Journal_append(&record))
+    {
+        uploadStats.journaled++;
+        return true;
+    }
+
+    uploadStats.dropped++;
+    return false;
+}
 
-    json.set(userPath.c_str(), String(""));
-    json.set(statusPath.c_str(), String("0"));
-    json.set(colorPath.c_str(), objectColorValue);
-    json.set(timePath.c_str(), objectDetectionTime);
+void Database_setRecordSchema(t_DatabaseSchema schema)
+{
+    uploadSchema = schema;
+}
 
-    return Firebase.RTDB.setJSON(&fbdo, parentPath, &json);
+void Database_setUploadMode(uint8_t mode)
+{
+    uploadMode = mode;
+}
+
+void Database_getStats(t_DatabaseStats * stats)
+{
+    *stats = uploadStats;
+    stats->dropped += Journal_getDropped();
 }
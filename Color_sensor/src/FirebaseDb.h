@@ -37,11 +37,65 @@ void Database_refreshConnection(void);
  */
 t_FirebaseState Database_getState(void);
 
-/* Push a color record to Firebase database
+/* Layout of object records in database
  *
- * input: pointer to color object
- * output: operation result: true for success, false otherwise
  */
-bool Database_pushObjectColor(t_Color * objectColor);
+typedef enum
+{
+    DATABASE_SCHEMA_LEGACY = 0,     /* Strings: "color":"r,g,b", "timestamp":"d/m/yyyy hh:mm:ss", "user", "status" */
+    DATABASE_SCHEMA_COMPACT,        /* Numbers: "r","g","b", "c" clear count, "t" epoch ms of detection, "k" color class if known */
+    DATABASE_SCHEMA_COMPACT_SERVER  /* As compact, "t" set by server on write ({".sv":"timestamp"}) */
+} t_DatabaseSchema;
+
+/* Select layout of object records uploaded from now on
+ * (default: DATABASE_SCHEMA_LEGACY)
+ *
+ * input: schema
+ * output: none
+ */
+void Database_setRecordSchema(t_DatabaseSchema schema);
+
+/* What is uploaded for each object (bit mask)
+ *
+ */
+#define DATABASE_UPLOAD_RAW 0x01       /* One record per object under /Data */
+#define DATABASE_UPLOAD_AGGREGATE 0x02 /* Object count per color class and minute under /Counts/<start>/<flush key> */
+
+/* Select what is uploaded from now on
+ * (default: DATABASE_UPLOAD_RAW)
+ *
+ * input: combination of DATABASE_UPLOAD_RAW and DATABASE_UPLOAD_AGGREGATE
+ * output: none
+ */
+void Database_setUploadMode(uint8_t mode);
+
+/* Upload queue counters
+ *
+ */
+typedef struct
+{
+    uint32_t queued;    /* Records accepted by Database_enqueueObject() */
+    uint32_t journaled; /* Records stored on flash while offline, replayed later */
+    uint32_t counted;   /* Objects added to per-minute histograms */
+    uint32_t sent;      /* Records pushed successfully */
+    uint32_t retried;   /* Failed push attempts that were scheduled again */
+    uint32_t dropped;   /* Records lost: journal full or corrupted, out of retries and journal unavailable */
+} t_DatabaseStats;
+
+/* Queue an object record for upload to Firebase database,
+ * returns immediately, the record is pushed by Database_task(),
+ * while offline it is kept in the flash journal and replayed on reconnection
+ *
+ * input: pointer to object record (copied)
+ * output: true if queued or journaled, false if the record is dropped
+ */
+bool Database_enqueueObject(const t_ObjectRecord * object);
+
+/* Get upload queue counters
+ *
+ * input: pointer to a buffer that receives the counters
+ * output: none
+ */
+void Database_getStats(t_DatabaseStats * stats);
 
 #endif /* FIREBASEDB_H */
@@ -0,0 +1,313 @@
+#include <stdio.h>
+#include "Journal.h"
+
+/* Records per segment file and segments kept before the oldest is discarded */
+#define JOURNAL_SEGMENT_RECORDS 64
+#define JOURNAL_MAX_SEGMENTS 32
+
+/* Marks a valid entry, changes whenever the record layout changes */
+#define JOURNAL_MAGIC (0x4A00 | (sizeof(t_ObjectRecord) & 0xFF))
+
+/* Replay cursor, written to both slots in turn: a write torn at power loss
+ * leaves the other slot, at most one commit behind */
+#define JOURNAL_CURSOR_SLOTS 2
+#define JOURNAL_CURSOR_PATH JOURNAL_DIRECTORY "/cursor%u.bin"
+#define JOURNAL_PATH_LENGTH 32
+
+typedef struct
+{
+    uint16_t magic;
+    uint16_t crc; /* CRC of record */
+    t_ObjectRecord record;
+} t_JournalEntry;
+
+typedef struct
+{
+    uint32_t sequence; /* Incremented on every save, the highest valid slot wins */
+    uint32_t segment;
+    uint32_t index;
+    uint16_t crc; /* CRC of sequence, segment and index */
+} t_JournalCursor;
+
+static const t_JournalStorage * Journal_storage = nullptr;
+
+/* Replay position (persisted) and append position (recovered from file sizes) */
+static uint32_t Journal_readSegment = 0, Journal_readIndex = 0;
+static uint32_t Journal_writeSegment = 0, Journal_writeIndex = 0;
+
+/* Position following the records returned by last Journal_read() */
+static uint32_t Journal_peekSegment = 0, Journal_peekIndex = 0;
+
+static uint32_t Journal_dropped = 0;
+static uint32_t Journal_cursorSequence = 0;
+
+/* CRC-16/CCITT-FALSE */
+static uint16_t Journal_crc16(const uint8_t * data, size_t length)
+{
+    uint16_t crc = 0xFFFF;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++)
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+    }
+
+    return crc;
+}
+
+static void Journal_segmentPath(uint32_t segment, char * path)
+{
+    snprintf(path, JOURNAL_PATH_LENGTH, JOURNAL_DIRECTORY "/%lu.bin", (unsigned long)segment);
+}
+
+/* Number of complete entries in a segment file */
+static uint32_t Journal_segmentEntries(uint32_t segment)
+{
+    if (segment == Journal_writeSegment)
+        return Journal_writeIndex;
+
+    char path[JOURNAL_PATH_LENGTH];
+    Journal_segmentPath(segment, path);
+
+    int32_t size = Journal_storage->size(path);
+    return (size > 0) ? ((uint32_t)size / sizeof(t_JournalEntry)) : 0;
+}
+
+static void Journal_removeSegment(uint32_t segment)
+{
+    char path[JOURNAL_PATH_LENGTH];
+    Journal_segmentPath(segment, path);
+    (void)Journal_storage->remove(path);
+}
+
+static void Journal_cursorPath(uint32_t slot, char * path)
+{
+    snprintf(path, JOURNAL_PATH_LENGTH, JOURNAL_CURSOR_PATH, (unsigned)slot);
+}
+
+static bool Journal_saveCursor(void)
+{
+    t_JournalCursor cursor = {Journal_cursorSequence + 1, Journal_readSegment, Journal_readIndex, 0};
+    cursor.crc = Journal_crc16((const uint8_t *)&cursor, offsetof(t_JournalCursor, crc));
+
+    char path[JOURNAL_PATH_LENGTH];
+    Journal_cursorPath(cursor.sequence % JOURNAL_CURSOR_SLOTS, path);
+
+    if (!Journal_storage->write(path, (const uint8_t *)&cursor, sizeof(cursor)))
+        return false;
+
+    Journal_cursorSequence = cursor.sequence;
+    return true;
+}
+
+/* Restore the newest valid cursor
+ *
+ * output: true if one was found
+ */
+static bool Journal_loadCursor(void)
+{
+    bool found = false;
+
+    Journal_readSegment = 0;
+    Journal_readIndex = 0;
+    Journal_cursorSequence = 0;
+
+    for (uint32_t slot = 0; slot < JOURNAL_CURSOR_SLOTS; slot++)
+    {
+        t_JournalCursor cursor;
+        char path[JOURNAL_PATH_LENGTH];
+        Journal_cursorPath(slot, path);
+
+        if (!Journal_storage->read(path, 0, (uint8_t *)&cursor, sizeof(cursor)) ||
+                (cursor.crc != Journal_crc16((const uint8_t *)&cursor, offsetof(t_JournalCursor, crc))))
+            continue;
+
+        if (!found || ((int32_t)(cursor.sequence - Journal_cursorSequence) > 0))
+        {
+            Journal_cursorSequence = cursor.sequence;
+            Journal_readSegment = cursor.segment;
+            Journal_readIndex = cursor.index;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+static bool Journal_segmentExists(uint32_t segment)
+{
+    char path[JOURNAL_PATH_LENGTH];
+    Journal_segmentPath(segment, path);
+    return Journal_storage->exists(path);
+}
+
+bool Journal_init(const t_JournalStorage * storage)
+{
+    Journal_storage = storage;
+    (void)Journal_loadCursor(); /* None (first boot, both slots lost): from segment 0 */
+
+    /* Segments left are the ones within reach of the cursor, gaps included:
+     * a commit interrupted by power loss may have removed some of them
+     * without saving the cursor, or the cursor may be a commit behind */
+    uint32_t cursorSegment = Journal_readSegment;
+    bool found = false;
+
+    Journal_writeSegment = cursorSegment;
+    for (uint32_t segment = cursorSegment; segment <= (cursorSegment + JOURNAL_MAX_SEGMENTS); segment++)
+    {
+        if (!Journal_segmentExists(segment))
+            continue;
+
+        if (!found)
+            Journal_readSegment = segment;
+        Journal_writeSegment = segment;
+        found = true;
+    }
+
+    /* Replay starts over in a segment after the cursor one */
+    if (Journal_readSegment != cursorSegment)
+        Journal_readIndex = 0;
+
+    char path[JOURNAL_PATH_LENGTH];
+    Journal_segmentPath(Journal_writeSegment, path);
+    int32_t size = Journal_storage->size(path);
+
+    if (size <= 0)
+        Journal_writeIndex = 0;
+    else if (((uint32_t)size % sizeof(t_JournalEntry)) != 0)
+    {
+        /* Torn write at power loss, keep the complete entries and continue in a fresh segment */
+        Journal_writeSegment++;
+        Journal_writeIndex = 0;
+    }
+    else
+        Journal_writeIndex = (uint32_t)size / sizeof(t_JournalEntry);
+
+    if ((Journal_readSegment == Journal_writeSegment) && (Journal_readIndex > Journal_writeIndex))
+        Journal_readIndex = Journal_writeIndex;
+
+    Journal_peekSegment = Journal_readSegment;
+    Journal_peekIndex = Journal_readIndex;
+
+    return true;
+}
+
+bool Journal_append(const t_ObjectRecord * record)
+{
+    if (Journal_storage == nullptr)
+        return false;
+
+    if (Journal_writeIndex >= JOURNAL_SEGMENT_RECORDS)
+    {
+        Journal_writeSegment++;
+        Journal_writeIndex = 0;
+    }
+
+    /* Full: give up the oldest segment */
+    if ((Journal_writeSegment - Journal_readSegment) >= JOURNAL_MAX_SEGMENTS)
+    {
+        Journal_dropped += Journal_segmentEntries(Journal_readSegment) - Journal_readIndex;
+        Journal_removeSegment(Journal_readSegment);
+
+        Journal_readSegment++;
+        Journal_readIndex = 0;
+        Journal_peekSegment = Journal_readSegment;
+        Journal_peekIndex = 0;
+        (void)Journal_saveCursor();
+    }
+
+    t_JournalEntry entry;
+    entry.magic = JOURNAL_MAGIC;
+    entry.crc = Journal_crc16((const uint8_t *)record, sizeof(t_ObjectRecord));
+    entry.record = *record;
+
+    char path[JOURNAL_PATH_LENGTH];
+    Journal_segmentPath(Journal_writeSegment, path);
+
+    if (!Journal_storage->append(path, (const uint8_t *)&entry, sizeof(entry)))
+        return false;
+
+    Journal_writeIndex++;
+    return true;
+}
+
+uint16_t Journal_read(t_ObjectRecord * records, uint16_t maxRecords)
+{
+    uint16_t count = 0;
+    uint32_t segment = Journal_readSegment;
+    uint32_t index = Journal_readIndex;
+
+    if (Journal_storage == nullptr)
+        return 0;
+
+    char path[JOURNAL_PATH_LENGTH];
+    Journal_segmentPath(segment, path);
+    uint32_t entries = Journal_segmentEntries(segment);
+
+    while ((count < maxRecords) && ((segment != Journal_writeSegment) || (index < Journal_writeIndex)))
+    {
+        /* End of segment, continue with the next one */
+        if (index >= entries)
+        {
+            segment++;
+            index = 0;
+            Journal_segmentPath(segment, path);
+            entries = Journal_segmentEntries(segment);
+            continue;
+        }
+
+        t_JournalEntry entry;
+        bool valid = Journal_storage->read(path, index * sizeof(t_JournalEntry), (uint8_t *)&entry, sizeof(entry)) &&
+                (entry.magic == JOURNAL_MAGIC) &&
+                (entry.crc == Journal_crc16((const uint8_t *)&entry.record, sizeof(t_ObjectRecord)));
+
+        if (valid)
+            records[count++] = entry.record;
+        else
+            Journal_dropped++;
+
+        index++;
+    }
+
+    Journal_peekSegment = segment;
+    Journal_peekIndex = index;
+    return count;
+}
+
+void Journal_commit(void)
+{
+    if (Journal_storage == nullptr)
+        return;
+
+    /* Segments fully replayed are not needed anymore */
+    while (Journal_readSegment < Journal_peekSegment)
+        Journal_removeSegment(Journal_readSegment++);
+
+    Journal_readIndex = Journal_peekIndex;
+
+    /* Everything replayed: drop the last segment too and start over from segment 0,
+     * so segment numbers stay low and a journal without cursor is still found */
+    if ((Journal_readSegment == Journal_writeSegment) && (Journal_readIndex >= Journal_writeIndex) && (Journal_writeIndex > 0))
+    {
+        Journal_removeSegment(Journal_writeSegment);
+        Journal_writeSegment = 0;
+        Journal_writeIndex = 0;
+        Journal_readSegment = 0;
+        Journal_readIndex = 0;
+    }
+
+    Journal_peekSegment = Journal_readSegment;
+    Journal_peekIndex = Journal_readIndex;
+    (void)Journal_saveCursor();
+}
+
+bool Journal_pending(void)
+{
+    return ((Journal_readSegment != Journal_writeSegment) || (Journal_readIndex < Journal_writeIndex));
+}
+
+uint32_t Journal_getDropped(void)
+{
+    return Journal_dropped;
+}
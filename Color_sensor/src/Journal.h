@@ -0,0 +1,75 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stddef.h>
+#include "Datatypes.h"
+
+/* File access used by the journal, so the same journal
+ * logic runs on flash (MB_FS) or on any other file store
+ *
+ */
+typedef struct
+{
+    bool (* exists)(const char * path);
+    int32_t (* size)(const char * path); /* -1 if the file does not exist */
+    bool (* read)(const char * path, uint32_t offset, uint8_t * buffer, size_t length);
+    bool (* append)(const char * path, const uint8_t * buffer, size_t length);
+    bool (* write)(const char * path, const uint8_t * buffer, size_t length); /* Replace whole file */
+    bool (* remove)(const char * path);
+} t_JournalStorage;
+
+/* Directory of the journal files in the storage */
+#define JOURNAL_DIRECTORY "/journal"
+
+/* Storage on the on-board flash file system (LittleFS through MB_FS,
+ * selected in Lib/Firebase_ESP32_Client/src/CustomFirebaseFS.h) */
+extern const t_JournalStorage Journal_flashStorage;
+
+/* Open the journal and restore the replay cursor
+ * persisted by a previous run
+ *
+ * input: pointer to storage
+ * output: true for success, false otherwise
+ */
+bool Journal_init(const t_JournalStorage * storage);
+
+/* Append a record at the end of the journal,
+ * the oldest segment is discarded when the journal is full
+ *
+ * input: pointer to record
+ * output: true for success, false otherwise
+ */
+bool Journal_append(const t_ObjectRecord * record);
+
+/* Read the next records to be replayed without consuming them,
+ * call Journal_commit() once they are safe elsewhere
+ *
+ * input: pointer to a buffer that receives the records, buffer capacity
+ * output: number of records read
+ */
+uint16_t Journal_read(t_ObjectRecord * records, uint16_t maxRecords);
+
+/* Consume the records returned by last Journal_read()
+ * and persist the replay cursor
+ *
+ * input: none
+ * output: none
+ */
+void Journal_commit(void);
+
+/* Check whether records are waiting for replay
+ *
+ * input: none
+ * output: true if the journal is not empty
+ */
+bool Journal_pending(void);
+
+/* Get number of records lost since boot
+ * (discarded when full or failing their checksum)
+ *
+ * input: none
+ * output: number of records
+ */
+uint32_t Journal_getDropped(void);
+
+#endif /* JOURNAL_H */
@@ -0,0 +1,90 @@
+#include <Arduino.h>
+#include "Lib/Firebase_ESP32_Client/src/mbfs/MB_FS.h"
+
+#include "Journal.h"
+
+/* Own MB_FS instance, it holds one open flash file at a time */
+static MB_FS Journal_fs;
+static bool JournalFlash_directoryReady = false;
+
+/* Create the journal directory before the first file is written,
+ * MB_FS only creates directories on file systems with long names
+ *
+ * input: none
+ * output: true once the flash is mounted and the directory exists
+ */
+static bool JournalFlash_createDirectory(void)
+{
+    if (JournalFlash_directoryReady)
+        return true;
+
+    if (!Journal_fs.flashReady())
+        return false;
+
+    /* Flat file systems (SPIFFS) have no directories, the path stays part of the name */
+    if (!MBFS_FLASH_FS.exists(JOURNAL_DIRECTORY))
+        (void)MBFS_FLASH_FS.mkdir(JOURNAL_DIRECTORY);
+
+    JournalFlash_directoryReady = true;
+    return true;
+}
+
+static bool JournalFlash_exists(const char * path)
+{
+    return Journal_fs.existed(path, mbfs_flash);
+}
+
+static int32_t JournalFlash_size(const char * path)
+{
+    int size = Journal_fs.open(path, mbfs_flash, mb_fs_open_mode_read);
+    Journal_fs.close(mbfs_flash);
+
+    return (size < 0) ? -1 : size;
+}
+
+static bool JournalFlash_read(const char * path, uint32_t offset, uint8_t * buffer, size_t length)
+{
+    if (Journal_fs.open(path, mbfs_flash, mb_fs_open_mode_read) < 0)
+        return false;
+
+    bool ok = Journal_fs.seek(mbfs_flash, offset) &&
+            (Journal_fs.read(mbfs_flash, buffer, length) == (int)length);
+
+    Journal_fs.close(mbfs_flash);
+    return ok;
+}
+
+static bool JournalFlash_store(const char * path, const uint8_t * buffer, size_t length, mb_fs_open_mode mode)
+{
+    if (!JournalFlash_createDirectory() || (Journal_fs.open(path, mbfs_flash, mode) < 0))
+        return false;
+
+    bool ok = (Journal_fs.write(mbfs_flash, (uint8_t *)buffer, length) == (int)length);
+
+    Journal_fs.close(mbfs_flash);
+    return ok;
+}
+
+static bool JournalFlash_append(const char * path, const uint8_t * buffer, size_t length)
+{
+    return JournalFlash_store(path, buffer, length, mb_fs_open_mode_append);
+}
+
+static bool JournalFlash_write(const char * path, const uint8_t * buffer, size_t length)
+{
+    return JournalFlash_store(path, buffer, length, mb_fs_open_mode_write);
+}
+
+static bool JournalFlash_remove(const char * path)
+{
+    return Journal_fs.remove(path, mbfs_flash);
+}
+
+const t_JournalStorage Journal_flashStorage = {
+    JournalFlash_exists,
+    JournalFlash_size,
+    JournalFlash_read,
+    JournalFlash_append,
+    JournalFlash_write,
+    JournalFlash_remove
+};
@@ -88,8 +88,9 @@ void Adafruit_TCS34725::enable() {
     AEN triggers an automatic integration, so if a read RGBC is
     performed too quickly, the data is not yet valid and all 0's are
     returned */
-  /* 12/5 = 2.4, add 1 to account for integer truncation */
-  delay((256 - _tcs34725IntegrationTime) * 12 / 5 + 1);
+  delay(integrationTimeMs());
+  _conversionStart = millis();
+  _conversionWait = integrationTimeMs();
 }
 
 /*!
@@ -113,6 +114,8 @@ Adafruit_TCS34725::Adafruit_TCS34725(uint8_t it, tcs34725Gain_t gain) {
   _tcs34725Initialised = false;
   _tcs34725IntegrationTime = it;
   _tcs34725Gain = gain;
+  _conversionStart = 0;
+  _conversionWait = 0;
 }
 
 /*!
@@ -146,9 +149,9 @@ boolean Adafruit_TCS34725::init() {
   }
   _tcs34725Initialised = true;
 
-  /* Set default integration time and gain */
-  setIntegrationTime(_tcs34725IntegrationTime);
-  setGain(_tcs34725Gain);
+  /* Set default integration time and gain, bypassing the register cache */
+  write8(TCS34725_ATIME, _tcs34725IntegrationTime);
+  write8(TCS34725_CONTROL, _tcs34725Gain);
 
   /* Note: by default, the device is in power down mode on bootup */
   enable();
@@ -165,6 +168,10 @@ void Adafruit_TCS34725::setIntegrationTime(uint8_t it) {
   if (!_tcs34725Initialised)
     begin();
 
+  /* Register already holds this value */
+  if (it == _tcs34725IntegrationTime)
+    return;
+
   /* Update the timing register */
   write8(TCS34725_ATIME, it);
 
@@ -181,6 +188,10 @@ void Adafruit_TCS34725::setGain(tcs34725Gain_t gain) {
   if (!_tcs34725Initialised)
     begin();
 
+  /* Register already holds this value */
+  if (gain == _tcs34725Gain)
+    return;
+
   /* Update the timing register */
   write8(TCS34725_CONTROL, gain);
 
@@ -188,6 +199,20 @@ void Adafruit_TCS34725::setGain(tcs34725Gain_t gain) {
   _tcs34725Gain = gain;
 }
 
+/*!
+ *  @brief  Returns the integration time currently programmed
+ *  @return Integration Time
+ */
+uint8_t Adafruit_TCS34725::getIntegrationTime() {
+  return _tcs34725IntegrationTime;
+}
+
+/*!
+ *  @brief  Returns the gain currently programmed
+ *  @return Gain
+ */
+tcs34725Gain_t Adafruit_TCS34725::getGain() { return _tcs34725Gain; }
+
 /*!
  *  @brief  Reads the raw red, green, blue and clear channel values
  *  @param  *r
@@ -204,14 +229,40 @@ void Adafruit_TCS34725::getRawData(uint16_t *r, uint16_t *g, uint16_t *b,
   if (!_tcs34725Initialised)
     begin();
 
-  *c = read16(TCS34725_CDATAL);
-  *r = read16(TCS34725_RDATAL);
-  *g = read16(TCS34725_GDATAL);
-  *b = read16(TCS34725_BDATAL);
+  tcs34725RawData_t data = {0, 0, 0, 0};
+  getRawDataBurst(&data);
+
+  *c = data.c;
+  *r = data.r;
+  *g = data.g;
+  *b = data.b;
 
   /* Set a delay for the integration time */
-  /* 12/5 = 2.4, add 1 to account for integer truncation */
-  delay((256 - _tcs34725IntegrationTime) * 12 / 5 + 1);
+  delay(integrationTimeMs());
+}
+
+/*!
+ *  @brief  Reads all four RGBC channels in a single I2C transaction. The
+ *          register pointer is set with the auto-increment command and the
+ *          8 data bytes are read after a repeated start, so every channel
+ *          comes from the same integration cycle.
+ *  @param  *data
+ *          Raw channel values, left untouched on bus error
+ *  @return True if the transfer succeeded, otherwise false.
+ */
+boolean Adafruit_TCS34725::getRawDataBurst(tcs34725RawData_t *data) {
+  uint8_t buffer[8] = {(uint8_t)(TCS34725_COMMAND_BIT |
+                                 TCS34725_COMMAND_AUTOINC | TCS34725_CDATAL)};
+
+  if (!i2c_dev->write_then_read(buffer, 1, buffer, sizeof(buffer)))
+    return false;
+
+  data->c = (uint16_t(buffer[1]) << 8) | buffer[0];
+  data->r = (uint16_t(buffer[3]) << 8) | buffer[2];
+  data->g = (uint16_t(buffer[5]) << 8) | buffer[4];
+  data->b = (uint16_t(buffer[7]) << 8) | buffer[6];
+
+  return true;
 }
 
 /*!
@@ -249,6 +300,44 @@ void Adafruit_TCS34725::getRawDataOneShot(uint16_t *r, uint16_t *g, uint16_t *b,
 void Adafruit_TCS34725::getRGB(float *r, float *g, float *b) {
   uint16_t red, green, blue, clear;
   getRawData(&red, &green, &blue, &clear);
+  normalizeRGB(red, green, blue, clear, r, g, b);
+}
+
+/*!
+ *  @brief  Read the RGB color detected by the sensor, integer version.
+ *  @param  *r
+ *          Red value normalized to 0-255
+ *  @param  *g
+ *          Green value normalized to 0-255
+ *  @param  *b
+ *          Blue value normalized to 0-255
+ */
+void Adafruit_TCS34725::getRGB(uint8_t *r, uint8_t *g, uint8_t *b) {
+  uint16_t red, green, blue, clear;
+  getRawData(&red, &green, &blue, &clear);
+  normalizeRGB(red, green, blue, clear, r, g, b);
+}
+
+/*!
+ *  @brief  Normalizes raw R/G/B values against the clear channel
+ *  @param  red
+ *          Raw red value
+ *  @param  green
+ *          Raw green value
+ *  @param  blue
+ *          Raw blue value
+ *  @param  clear
+ *          Raw clear channel value
+ *  @param  *r
+ *          Red value normalized to 0-255
+ *  @param  *g
+ *          Green value normalized to 0-255
+ *  @param  *b
+ *          Blue value normalized to 0-255
+ */
+void Adafruit_TCS34725::normalizeRGB(uint16_t red, uint16_t green,
+                                     uint16_t blue, uint16_t clear, float *r,
+                                     float *g, float *b) {
   uint32_t sum = clear;
 
   // Avoid divide by zero errors ... if clear = 0 return black
@@ -262,6 +351,193 @@ void Adafruit_TCS34725::getRGB(float *r, float *g, float *b) {
   *b = (float)blue / sum * 255.0;
 }
 
+/*!
+ *  @brief  Scales one raw channel with a Q16 reciprocal of the clear channel
+ *  @param  value
+ *          Raw channel value
+ *  @param  clear
+ *          Raw clear channel value, not zero
+ *  @param  recip
+ *          (255 << 16) / clear
+ *  @return Channel value normalized to 0-255
+ */
+static uint8_t scaleChannel(uint16_t value, uint16_t clear, uint32_t recip) {
+  /* value < clear keeps the product below 255 << 16 */
+  if (value >= clear)
+    return 255;
+  return (uint8_t)(((uint32_t)value * recip) >> 16);
+}
+
+/*!
+ *  @brief  Normalizes raw R/G/B values against the clear channel without
+ *          floating point. A single division builds the reciprocal of the
+ *          clear channel, each channel then costs one multiply and shift.
+ *          Results match the float version truncated to 8 bits within 1 LSB.
+ *  @param  red
+ *          Raw red value
+ *  @param  green
+ *          Raw green value
+ *  @param  blue
+ *          Raw blue value
+ *  @param  clear
+ *          Raw clear channel value
+ *  @param  *r
+ *          Red value normalized to 0-255
+ *  @param  *g
+ *          Green value normalized to 0-255
+ *  @param  *b
+ *          Blue value normalized to 0-255
+ */
+void Adafruit_TCS34725::normalizeRGB(uint16_t red, uint16_t green,
+                                     uint16_t blue, uint16_t clear, uint8_t *r,
+                                     uint8_t *g, uint8_t *b) {
+  // Avoid divide by zero errors ... if clear = 0 return black
+  if (clear == 0) {
+    *r = *g = *b = 0;
+    return;
+  }
+
+  uint32_t recip = ((uint32_t)255 << 16) / clear;
+
+  *r = scaleChannel(red, clear, recip);
+  *g = scaleChannel(green, clear, recip);
+  *b = scaleChannel(blue, clear, recip);
+}
+
+/*!
+ *  @brief  Returns the duration of one RGBC integration cycle
+ *  @return Integration time in milliseconds, rounded up
+ */
+uint32_t Adafruit_TCS34725::integrationTimeMs() {
+  /* 12/5 = 2.4, add 1 to account for integer truncation */
+  return (256 - _tcs34725IntegrationTime) * 12 / 5 + 1;
+}
+
+/*!
+ *  @brief  Restarts the RGBC integration cycle without waiting for it.
+ *          Toggling AEN discards the running cycle and clears AVALID, so the
+ *          next sample is guaranteed to use the current integration time and
+ *          gain. The first cycle starts after the RGBC init time.
+ *          The other ENABLE bits (AIEN, WEN) are kept as they are.
+ *          Use dataReady() or getRawDataAsync() to collect the result.
+ */
+void Adafruit_TCS34725::startConversion() {
+  if (!_tcs34725Initialised)
+    begin();
+
+  uint8_t enable = read8(TCS34725_ENABLE) | TCS34725_ENABLE_PON;
+  write8(TCS34725_ENABLE, enable & ~TCS34725_ENABLE_AEN);
+  write8(TCS34725_ENABLE, enable | TCS34725_ENABLE_AEN);
+  _conversionStart = millis();
+  _conversionWait = TCS34725_INIT_TIME_MS + integrationTimeMs();
+}
+
+/*!
+ *  @brief  Checks whether the current RGBC integration cycle has completed.
+ *          The bus is only touched once the integration deadline has passed,
+ *          after which the AVALID status bit is polled. AVALID only tells
+ *          the first cycle after startConversion() apart, it stays set
+ *          afterwards: a later sample is fresh because the deadline runs
+ *          one full cycle from the previous read.
+ *  @return True if a fresh sample can be read, otherwise false.
+ */
+boolean Adafruit_TCS34725::dataReady() {
+  if ((uint32_t)(millis() - _conversionStart) < _conversionWait)
+    return false;
+
+  return (read8(TCS34725_STATUS) & TCS34725_STATUS_AVALID) != 0;
+}
+
+/*!
+ *  @brief  Time left until dataReady() polls the device, so the caller
+ *          can sleep instead of polling. Touches no register.
+ *  @return Milliseconds until the integration deadline, 0 once passed.
+ */
+uint32_t Adafruit_TCS34725::timeToDataReady() {
+  uint32_t elapsed = millis() - _conversionStart;
+  return (elapsed < _conversionWait) ? (_conversionWait - elapsed) : 0;
+}
+
+/*!
+ *  @brief  Reads the raw red, green, blue and clear channel values if an
+ *          integration cycle has completed, without blocking. The device keeps
+ *          integrating in the background, so the next sample is expected one
+ *          integration time later.
+ *  @param  *r
+ *          Red value
+ *  @param  *g
+ *          Green value
+ *  @param  *b
+ *          Blue value
+ *  @param  *c
+ *          Clear channel value
+ *  @return True if the values were updated, false if no sample is ready yet.
+ */
+boolean Adafruit_TCS34725::getRawDataAsync(uint16_t *r, uint16_t *g,
+                                           uint16_t *b, uint16_t *c) {
+  if (!_tcs34725Initialised)
+    begin();
+
+  if (!dataReady())
+    return false;
+
+  tcs34725RawData_t data;
+  if (!getRawDataBurst(&data))
+    return false;
+
+  *c = data.c;
+  *r = data.r;
+  *g = data.g;
+  *b = data.b;
+
+  /* The device runs freely, the cycle running now ends within one
+   * integration time (AVALID stays set, so the deadline is all that
+   * keeps the same sample from being read twice) */
+  _conversionStart = millis();
+  _conversionWait = integrationTimeMs();
+
+  return true;
+}
+
+/*!
+ *  @brief  Read the RGB color detected by the sensor without blocking.
+ *  @param  *r
+ *          Red value normalized to 0-255
+ *  @param  *g
+ *          Green value normalized to 0-255
+ *  @param  *b
+ *          Blue value normalized to 0-255
+ *  @return True if the values were updated, false if no sample is ready yet.
+ */
+boolean Adafruit_TCS34725::getRGBAsync(float *r, float *g, float *b) {
+  uint16_t red, green, blue, clear;
+  if (!getRawDataAsync(&red, &green, &blue, &clear))
+    return false;
+
+  normalizeRGB(red, green, blue, clear, r, g, b);
+  return true;
+}
+
+/*!
+ *  @brief  Read the RGB color detected by the sensor without blocking,
+ *          integer version.
+ *  @param  *r
+ *          Red value normalized to 0-255
+ *  @param  *g
+ *          Green value normalized to 0-255
+ *  @param  *b
+ *          Blue value normalized to 0-255
+ *  @return True if the values were updated, false if no sample is ready yet.
+ */
+boolean Adafruit_TCS34725::getRGBAsync(uint8_t *r, uint8_t *g, uint8_t *b) {
+  uint16_t red, green, blue, clear;
+  if (!getRawDataAsync(&red, &green, &blue, &clear))
+    return false;
+
+  normalizeRGB(red, green, blue, clear, r, g, b);
+  return true;
+}
+
 /*!
  *  @brief  Converts the raw R/G/B values to color temperature in degrees Kelvin
  *  @param  r
@@ -298,38 +574,22 @@ uint16_t Adafruit_TCS34725::calculateColorTemperature(uint16_t r, uint16_t g,
   /* 3. Use McCamy's formula to determine the CCT    */
   n = (xc - 0.3320F) / (0.1858F - yc);
 
-  /* Calculate the final CCT */
-  cct =
-      (449.0F * powf(n, 3)) + (3525.0F * powf(n, 2)) + (6823.3F * n) + 5520.33F;
+  /* Calculate the final CCT (Horner form, stays in single precision) */
+  cct = ((449.0F * n + 3525.0F) * n + 6823.3F) * n + 5520.33F;
 
   /* Return the results in degrees Kelvin */
   return (uint16_t)cct;
 }
 
 /*!
- *  @brief  Converts the raw R/G/B values to color temperature in degrees
- *          Kelvin using the algorithm described in DN40 from Taos (now AMS).
- *  @param  r
- *          Red value
- *  @param  g
- *          Green value
- *  @param  b
- *          Blue value
- *  @param  c
- *          Clear channel value
- *  @return Color temperature in degrees Kelvin
+ *  @brief  Returns the clear channel count at which a sample must be treated
+ *          as saturated, following DN40 from Taos (now AMS).
+ *  @param  it
+ *          Integration Time
+ *  @return Saturation level in counts
  */
-uint16_t Adafruit_TCS34725::calculateColorTemperature_dn40(uint16_t r,
-                                                           uint16_t g,
-                                                           uint16_t b,
-                                                           uint16_t c) {
-  uint16_t r2, b2; /* RGB values minus IR component */
-  uint16_t sat;    /* Digital saturation level */
-  uint16_t ir;     /* Inferred IR content */
-
-  if (c == 0) {
-    return 0;
-  }
+uint16_t Adafruit_TCS34725::saturationLevel(uint8_t it) {
+  uint16_t sat; /* Digital saturation level */
 
   /* Analog/Digital saturation:
    *
@@ -343,12 +603,12 @@ uint16_t Adafruit_TCS34725::calculateColorTemperature_dn40(uint16_t r,
    *     occur before analog saturation. Digital saturation occurs when
    *     the count reaches 65535.
    */
-  if ((256 - _tcs34725IntegrationTime) > 63) {
+  if ((256 - it) > 63) {
     /* Track digital saturation */
     sat = 65535;
   } else {
     /* Track analog saturation */
-    sat = 1024 * (256 - _tcs34725IntegrationTime);
+    sat = 1024 * (256 - it);
   }
 
   /* Ripple rejection:
@@ -368,11 +628,41 @@ uint16_t Adafruit_TCS34725::calculateColorTemperature_dn40(uint16_t r,
    *     ignored, but <= 150ms you should calculate the 75% saturation
    *     level to avoid this problem.
    */
-  if ((256 - _tcs34725IntegrationTime) <= 63) {
+  if ((256 - it) <= 63) {
     /* Adjust sat to 75% to avoid analog saturation if atime < 153.6ms */
     sat -= sat / 4;
   }
 
+  return sat;
+}
+
+/*!
+ *  @brief  Converts the raw R/G/B values to color temperature in degrees
+ *          Kelvin using the algorithm described in DN40 from Taos (now AMS).
+ *  @param  r
+ *          Red value
+ *  @param  g
+ *          Green value
+ *  @param  b
+ *          Blue value
+ *  @param  c
+ *          Clear channel value
+ *  @return Color temperature in degrees Kelvin
+ */
+uint16_t Adafruit_TCS34725::calculateColorTemperature_dn40(uint16_t r,
+                                                           uint16_t g,
+                                                           uint16_t b,
+                                                           uint16_t c) {
+  uint16_t r2, b2; /* RGB values minus IR component */
+  uint16_t sat;    /* Digital saturation level */
+  uint16_t ir;     /* Inferred IR content */
+
+  if (c == 0) {
+    return 0;
+  }
+
+  sat = saturationLevel(_tcs34725IntegrationTime);
+
   /* Check for saturation and mark the sample as invalid if true */
   if (c >= sat) {
     return 0;
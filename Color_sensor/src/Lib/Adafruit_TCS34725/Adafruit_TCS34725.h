@@ -43,6 +43,8 @@
 
 #define TCS34725_ADDRESS (0x29)     /**< I2C address **/
 #define TCS34725_COMMAND_BIT (0x80) /**< Command bit **/
+#define TCS34725_COMMAND_AUTOINC                                               \
+  (0x20) /**< Auto-increment protocol transaction (TYPE = 01) */
 #define TCS34725_ENABLE (0x00)      /**< Interrupt Enable register */
 #define TCS34725_ENABLE_AIEN (0x10) /**< RGBC Interrupt Enable */
 #define TCS34725_ENABLE_WEN                                                    \
@@ -137,6 +139,9 @@
 #define TCS34725_BDATAL (0x1A) /**< Blue channel data low byte */
 #define TCS34725_BDATAH (0x1B) /**< Blue channel data high byte */
 
+#define TCS34725_INIT_TIME_MS                                                  \
+  (3) /**< RGBC init before the first cycle after AEN is set, 2.4ms rounded up */
+
 /** Integration time settings for TCS34725 */
 /*
  * 60-Hz period: 16.67ms, 50-Hz period: 20ms
@@ -189,6 +194,14 @@ typedef enum {
   TCS34725_GAIN_60X = 0x03  /**<  60x gain */
 } tcs34725Gain_t;
 
+/** Raw RGBC sample, in the order of the CDATAL..BDATAH register block */
+typedef struct __attribute__((packed)) {
+  uint16_t c; /**< Clear channel value */
+  uint16_t r; /**< Red channel value */
+  uint16_t g; /**< Green channel value */
+  uint16_t b; /**< Blue channel value */
+} tcs34725RawData_t;
+
 /*!
  *  @brief  Class that stores state and functions for interacting with
  *          TCS34725 Color Sensor
@@ -203,9 +216,24 @@ public:
 
   void setIntegrationTime(uint8_t it);
   void setGain(tcs34725Gain_t gain);
+  uint8_t getIntegrationTime();
+  tcs34725Gain_t getGain();
+  static uint16_t saturationLevel(uint8_t it);
   void getRawData(uint16_t *r, uint16_t *g, uint16_t *b, uint16_t *c);
+  boolean getRawDataBurst(tcs34725RawData_t *data);
   void getRGB(float *r, float *g, float *b);
+  void getRGB(uint8_t *r, uint8_t *g, uint8_t *b);
   void getRawDataOneShot(uint16_t *r, uint16_t *g, uint16_t *b, uint16_t *c);
+  void startConversion();
+  boolean dataReady();
+  uint32_t timeToDataReady();
+  boolean getRawDataAsync(uint16_t *r, uint16_t *g, uint16_t *b, uint16_t *c);
+  boolean getRGBAsync(float *r, float *g, float *b);
+  boolean getRGBAsync(uint8_t *r, uint8_t *g, uint8_t *b);
+  void normalizeRGB(uint16_t red, uint16_t green, uint16_t blue,
+                    uint16_t clear, float *r, float *g, float *b);
+  void normalizeRGB(uint16_t red, uint16_t green, uint16_t blue,
+                    uint16_t clear, uint8_t *r, uint8_t *g, uint8_t *b);
   uint16_t calculateColorTemperature(uint16_t r, uint16_t g, uint16_t b);
   uint16_t calculateColorTemperature_dn40(uint16_t r, uint16_t g, uint16_t b,
                                           uint16_t c);
@@ -224,6 +252,9 @@ private:
   boolean _tcs34725Initialised;
   tcs34725Gain_t _tcs34725Gain;
   uint8_t _tcs34725IntegrationTime;
+  uint32_t _conversionStart; ///< millis() when the current RGBC cycle began
+  uint32_t _conversionWait;  ///< ms from _conversionStart until a fresh sample
+  uint32_t integrationTimeMs();
 };
 
 #endif
@@ -0,0 +1,17 @@
+#pragma once
+
+#ifndef CustomFirebaseFS_H
+#define CustomFirebaseFS_H
+
+/* Project settings of the Firebase client, included at the end of
+ * FirebaseFS.h so the library header itself stays as released */
+
+/* Flash file system of the offline journal (Journal.h):
+ * LittleFS survives power loss mid-write and has directories */
+#if defined(ESP32)
+#include <LittleFS.h>
+#undef DEFAULT_FLASH_FS
+#define DEFAULT_FLASH_FS LittleFS
+#endif
+
+#endif
@@ -1596,6 +1596,24 @@ public:
                         _IS_ASYNC, _NO_QUEUE, _NO_BLOB_SIZE, toStringPtr(_NO_FILE));
   }
 
+  /** Update (patch) the child (s) nodes to the defined node from serialized JSON.
+   *
+   * @param fbdo The pointer to Firebase Data Object.
+   * @param path The path to the node in which child (s) nodes will be updated.
+   * @param raw The JSON object string used for the update, sent as is without parsing.
+   * @return Boolean value, indicates the success of the operation.
+   *
+   * @note No payload will be returned from the server.
+   * @note raw is copied into the request payload (MB_String); path and headers are heap strings as for any call.
+   */
+  template <typename T = const char *>
+  bool updateNodeSilentRaw(FirebaseData *fbdo, T path, const char *raw)
+  {
+    return buildRequest(fbdo, m_patch_nocontent, toStringPtr(path), toStringPtr(raw),
+                        d_json, _NO_SUB_TYPE, _NO_REF, _NO_QUERY, _NO_PRIORITY, toStringPtr(_NO_ETAG),
+                        _NO_ASYNC, _NO_QUEUE, _NO_BLOB_SIZE, toStringPtr(_NO_FILE));
+  }
+
   /** Read generic type of value at the defined node.
    *
    * @param fbdo The pointer to Firebase Data Object.
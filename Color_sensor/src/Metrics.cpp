@@ -0,0 +1,136 @@
+#include "Metrics.h"
+
+#if METRICS_ENABLE
+
+static const char * const Metrics_stageNames[METRICS_STAGE_COUNT] = {"app", "database", "ready", "push"};
+
+static t_MetricsHistogram Metrics_histograms[METRICS_STAGE_COUNT];
+static uint32_t Metrics_cpuMhz = 240;
+
+void Metrics_init(void)
+{
+    memset(Metrics_histograms, 0, sizeof(Metrics_histograms));
+
+    uint32_t mhz = ESP.getCpuFreqMHz();
+    if (mhz > 0)
+        Metrics_cpuMhz = mhz;
+}
+
+/* Bucket of a duration: values below 4 us have their own bucket,
+ * above each power of two is split in 4 (2 bits after the leading one)
+ */
+static uint8_t Metrics_bucket(uint32_t duration)
+{
+    if (duration < 4)
+        return (uint8_t)duration;
+
+    uint8_t msb = 31 - __builtin_clz(duration);
+    uint32_t index = ((msb - 1) * 4) + ((duration >> (msb - 2)) & 3);
+
+    return (index < METRICS_BUCKETS) ? (uint8_t)index : (METRICS_BUCKETS - 1);
+}
+
+/* Largest duration falling in a bucket */
+static uint32_t Metrics_bucketLimit(uint8_t index)
+{
+    if (index < 4)
+        return index;
+
+    uint8_t msb = (index / 4) + 1;
+    uint32_t lower = (uint32_t)(4 + (index % 4)) << (msb - 2);
+
+    return lower + (1UL << (msb - 2)) - 1;
+}
+
+void Metrics_record(t_MetricsStage stage, uint32_t cycles)
+{
+    t_MetricsHistogram * histogram = &Metrics_histograms[stage];
+    uint32_t duration = cycles / Metrics_cpuMhz;
+
+    if ((histogram->count == 0) || (duration < histogram->min))
+        histogram->min = duration;
+    if (duration > histogram->max)
+        histogram->max = duration;
+
+    histogram->count++;
+    histogram->total += duration;
+    histogram->buckets[Metrics_bucket(duration)]++;
+}
+
+/* Duration below which a percentage of runs fall */
+static uint32_t Metrics_percentile(const t_MetricsHistogram * histogram, uint8_t percent)
+{
+    uint32_t rank = (uint32_t)(((uint64_t)histogram->count * percent + 99) / 100);
+    uint32_t cumulated = 0;
+
+    for (uint8_t i = 0; i < METRICS_BUCKETS; i++)
+    {
+        cumulated += histogram->buckets[i];
+        if (cumulated >= rank)
+        {
+            uint32_t limit = Metrics_bucketLimit(i);
+            return (limit < histogram->max) ? limit : histogram->max;
+        }
+    }
+
+    return histogram->max;
+}
+
+void Metrics_getSummary(t_MetricsStage stage, t_MetricsSummary * summary)
+{
+    /* Copy first, the owning task may record meanwhile */
+    static t_MetricsHistogram histogram;
+    histogram = Metrics_histograms[stage];
+
+    summary->count = histogram.count;
+    summary->min = histogram.min;
+    summary->max = histogram.max;
+    summary->average = (histogram.count > 0) ? (uint32_t)(histogram.total / histogram.count) : 0;
+    summary->p50 = Metrics_percentile(&histogram, 50);
+    summary->p90 = Metrics_percentile(&histogram, 90);
+    summary->p99 = Metrics_percentile(&histogram, 99);
+}
+
+void Metrics_print(void)
+{
+    Serial.println("Stage latency (us):");
+
+    for (uint8_t stage = 0; stage < METRICS_STAGE_COUNT; stage++)
+    {
+        t_MetricsSummary summary;
+        Metrics_getSummary((t_MetricsStage)stage, &summary);
+
+        Serial.printf("  %-10s n %u, min %u, avg %u, p50 %u, p90 %u, p99 %u, max %u\n", Metrics_stageNames[stage],
+                summary.count, summary.min, summary.average, summary.p50, summary.p90, summary.p99, summary.max);
+    }
+}
+
+size_t Metrics_serialize(char * buffer, size_t size)
+{
+    size_t length = 0;
+
+    for (uint8_t stage = 0; stage < METRICS_STAGE_COUNT; stage++)
+    {
+        t_MetricsSummary summary;
+        Metrics_getSummary((t_MetricsStage)stage, &summary);
+
+        int written = snprintf(&buffer[length], size - length,
+                "%c\"%s\":{\"n\":%u,\"min\":%u,\"avg\":%u,\"p50\":%u,\"p90\":%u,\"p99\":%u,\"max\":%u}",
+                (stage == 0) ? '{' : ',', Metrics_stageNames[stage],
+                summary.count, summary.min, summary.average, summary.p50, summary.p90, summary.p99, summary.max);
+
+        if ((written < 0) || ((size_t)written >= (size - length)))
+            return 0;
+        length += written;
+    }
+
+    if ((length + 2) > size)
+        return 0;
+
+    buffer[length++] = '}';
+    buffer[length] = '\0';
+
+    return length;
+}
+
+#endif /* METRICS_ENABLE */
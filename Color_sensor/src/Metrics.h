@@ -0,0 +1,118 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+
+/* Stage latency instrumentation (1), or none at all (0):
+ * when disabled, METRICS_xxx macros expand to nothing and
+ * no code nor RAM is used
+ */
+#ifndef METRICS_ENABLE
+#define METRICS_ENABLE 1
+#endif
+
+/* Instrumented stages
+ *
+ */
+typedef enum
+{
+    METRICS_APP_TASK = 0,   /* App_task() */
+    METRICS_DATABASE_TASK,  /* Database_task() */
+    METRICS_FIREBASE_READY, /* Firebase.ready() */
+    METRICS_FIREBASE_PUSH,  /* One upload request */
+    METRICS_STAGE_COUNT
+} t_MetricsStage;
+
+/* Histogram buckets: 4 per power of two of microseconds (25% resolution),
+ * values from 0 to about 33 s, longer ones go to the last bucket */
+#define METRICS_BUCKETS 100
+
+/* Latency distribution of a stage, durations in microseconds
+ *
+ */
+typedef struct
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t buckets[METRICS_BUCKETS];
+} t_MetricsHistogram;
+
+/* Summary of a histogram, percentiles rounded up to their bucket bound
+ *
+ */
+typedef struct
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t average;
+    uint32_t p50;
+    uint32_t p90;
+    uint32_t p99;
+} t_MetricsSummary;
+
+#if METRICS_ENABLE
+
+/* Take a cycle counter timestamp before a stage */
+#define METRICS_START(timestamp) uint32_t timestamp = Metrics_now()
+
+/* Record time elapsed since METRICS_START() as one run of a stage,
+ * start and stop must run on the same core (cycle counter is per core) */
+#define METRICS_STOP(stage, timestamp) Metrics_record((stage), Metrics_now() - (timestamp))
+
+/* Read the cycle counter of the current core
+ *
+ * input: none
+ * output: CPU cycles, wraps after about 17 s at 240 MHz
+ */
+static inline uint32_t Metrics_now(void)
+{
+    return ESP.getCycleCount();
+}
+
+/* Reset all histograms
+ *
+ * input: none
+ * output: none
+ */
+void Metrics_init(void);
+
+/* Add one run of a stage, each stage must be recorded by one task only
+ *
+ * input: stage, duration in CPU cycles
+ * output: none
+ */
+void Metrics_record(t_MetricsStage stage, uint32_t cycles);
+
+/* Get min, max, average and percentiles of a stage
+ *
+ * input: stage, pointer to a buffer that receives the summary
+ * output: none
+ */
+void Metrics_getSummary(t_MetricsStage stage, t_MetricsSummary * summary);
+
+/* Print summary of every stage on Serial
+ *
+ * input: none
+ * output: none
+ */
+void Metrics_print(void);
+
+/* Write summary of every stage as a JSON object
+ * {"<stage>":{"n":..,"min":..,"avg":..,"p50":..,"p90":..,"p99":..,"max":..},...}
+ *
+ * input: buffer, size of buffer
+ * output: length written, 0 if the buffer is too small
+ */
+size_t Metrics_serialize(char * buffer, size_t size);
+
+#else
+
+#define METRICS_START(timestamp)
+#define METRICS_STOP(stage, timestamp)
+
+#endif /* METRICS_ENABLE */
+
+#endif /* METRICS_H */
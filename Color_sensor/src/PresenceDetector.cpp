@@ -0,0 +1,53 @@
+#include <Arduino.h>
+
+#include "PresenceDetector.h"
+#include "Calib.h"
+
+static int32_t Presence_clamp(int32_t value)
+{
+    if (value > PRESENCE_EVIDENCE_LIMIT)
+        return PRESENCE_EVIDENCE_LIMIT;
+    if (value < -PRESENCE_EVIDENCE_LIMIT)
+        return -PRESENCE_EVIDENCE_LIMIT;
+    return value;
+}
+
+void Presence_init(t_PresenceDetector * detector)
+{
+    detector->evidence = 0;
+    detector->state = PRESENCE_EMPTY;
+    detector->edge = 0;
+}
+
+int32_t Presence_evidence(int32_t delta, uint16_t sigma)
+{
+    if (sigma == 0)
+        sigma = 1;
+
+    /* Unit variance: llr = m * (z - m / 2), z = delta / sigma */
+    int32_t z = (delta * 256) / sigma;
+    int32_t llr = (PRESENCE_EXPECTED_SHIFT * z) - (PRESENCE_EXPECTED_SHIFT * PRESENCE_EXPECTED_SHIFT * 128);
+
+    return Presence_clamp(llr);
+}
+
+bool Presence_update(t_PresenceDetector * detector, int32_t evidence)
+{
+    /* Evidence toward the other state is positive for "object" when empty, negative when present */
+    int32_t toward = (detector->state == PRESENCE_EMPTY) ? Presence_clamp(evidence) : -Presence_clamp(evidence);
+
+    /* A new run starts here */
+    if ((detector->evidence == 0) && (toward > 0))
+        detector->edge = millis();
+
+    detector->evidence += toward;
+    if (detector->evidence < 0)
+        detector->evidence = 0; /* Readings confirm current state: no evidence kept */
+
+    if (detector->evidence < PRESENCE_DECISION_THRESHOLD)
+        return false;
+
+    detector->state = (detector->state == PRESENCE_EMPTY) ? PRESENCE_OBJECT : PRESENCE_EMPTY;
+    detector->evidence = 0;
+    return true;
+}
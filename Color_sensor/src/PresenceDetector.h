@@ -0,0 +1,50 @@
+#ifndef PRESENCEDETECTOR_H
+#define PRESENCEDETECTOR_H
+
+#include <stdint.h>
+
+/* Decided state of a sensor stage
+ *
+ */
+typedef enum
+{
+    PRESENCE_EMPTY = 0,
+    PRESENCE_OBJECT
+} t_Presence;
+
+/* Sequential test of "object" against "empty belt" (CUSUM form of
+ * Wald's SPRT): log-likelihood ratios of readings are summed until
+ * the sum reaches the decision threshold for the other state, so
+ * strong evidence decides in fewer readings than weak evidence
+ *
+ */
+typedef struct
+{
+    int32_t evidence; /* Q8 log-likelihood ratio toward the other state, 0 when none */
+    t_Presence state;
+    uint32_t edge;    /* millis() of the first reading of the run that changed state */
+} t_PresenceDetector;
+
+/* Reset a detector to empty state
+ *
+ * input: pointer to detector
+ * output: none
+ */
+void Presence_init(t_PresenceDetector * detector);
+
+/* Log-likelihood ratio of one reading, assuming gaussian noise
+ * and an object shifting the reading by PRESENCE_EXPECTED_SHIFT sigmas
+ *
+ * input: difference of reading from empty-belt baseline (positive toward object), noise sigma
+ * output: Q8 log-likelihood ratio, positive for object, bounded to +/- PRESENCE_EVIDENCE_LIMIT
+ */
+int32_t Presence_evidence(int32_t delta, uint16_t sigma);
+
+/* Add the evidence of one reading (sum of independent channels)
+ *
+ * input: pointer to detector, Q8 log-likelihood ratio
+ * output: true if the state changed with this reading
+ */
+bool Presence_update(t_PresenceDetector * detector, int32_t evidence);
+
+#endif /* PRESENCEDETECTOR_H */
@@ -0,0 +1,61 @@
+#include <Arduino.h>
+#include <Preferences.h>
+
+#include "RecordKey.h"
+
+#define RECORD_KEY_TIME_CHARS 8
+#define RECORD_KEY_BOOT_CHARS 3
+#define RECORD_KEY_SEQUENCE_CHARS 4
+
+/* Same alphabet as Firebase push IDs, ordered by ASCII code so keys sort as strings */
+static const char RecordKey_alphabet[] = "-0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ_abcdefghijklmnopqrstuvwxyz";
+
+static bool RecordKey_ready = false;
+static uint32_t RecordKey_boot = 0;
+static uint32_t RecordKey_sequence = 0;
+static uint64_t RecordKey_lastTime = 0;
+
+/* Read and bump boot counter, once per boot */
+static void RecordKey_init(void)
+{
+    Preferences preferences;
+
+    if (preferences.begin("recordkey", false))
+    {
+        RecordKey_boot = preferences.getULong("boot", 0) + 1;
+        preferences.putULong("boot", RecordKey_boot);
+        preferences.end();
+    }
+    else /* No NVS: random boot id still makes collisions unlikely */
+        RecordKey_boot = esp_random();
+
+    RecordKey_ready = true;
+}
+
+/* Write the lowest 6 * count bits of value, most significant character first */
+static char * RecordKey_encode(char * key, uint64_t value, uint8_t count)
+{
+    for (int8_t i = count - 1; i >= 0; i--)
+    {
+        key[i] = RecordKey_alphabet[value & 0x3F];
+        value >>= 6;
+    }
+
+    return key + count;
+}
+
+void RecordKey_generate(uint64_t timeMs, char * key)
+{
+    if (!RecordKey_ready)
+        RecordKey_init();
+
+    /* Monotonic: a clock stepped back by SNTP must not reorder keys */
+    if (timeMs < RecordKey_lastTime)
+        timeMs = RecordKey_lastTime;
+    RecordKey_lastTime = timeMs;
+
+    key = RecordKey_encode(key, timeMs, RECORD_KEY_TIME_CHARS);
+    key = RecordKey_encode(key, RecordKey_boot, RECORD_KEY_BOOT_CHARS);
+    key = RecordKey_encode(key, RecordKey_sequence++, RECORD_KEY_SEQUENCE_CHARS);
+    *key = '\0';
+}
@@ -0,0 +1,21 @@
+#ifndef RECORDKEY_H
+#define RECORDKEY_H
+
+#include <stdint.h>
+
+/* Key characters: 8 for time in ms, 3 for boot counter, 4 for sequence */
+#define RECORD_KEY_LENGTH 15
+
+/* Generate a database key for a record, in the spirit of
+ * Firebase push IDs but without server round trip.
+ * Keys sort by time, are unique per device (boot counter
+ * persisted in NVS, sequence within a boot) and never
+ * go backwards even if the clock does
+ *
+ * input: wall-clock time of the record in milliseconds since epoch,
+ *        pointer to a buffer of RECORD_KEY_LENGTH + 1 characters
+ * output: none
+ */
+void RecordKey_generate(uint64_t timeMs, char * key);
+
+#endif /* RECORDKEY_H */
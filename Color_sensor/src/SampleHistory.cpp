@@ -0,0 +1,59 @@
+#include "SampleHistory.h"
+
+void SampleHistory_init(t_SampleHistory * history, uint8_t window)
+{
+    history->window = ((window > 0) && (window <= SAMPLE_HISTORY_SIZE)) ? window : SAMPLE_HISTORY_SIZE;
+    history->head = 0;
+    history->count = 0;
+}
+
+/* Sorted array is kept up to date with one removal and one insertion,
+ * each a shift of at most window entries */
+static void SampleHistory_removeSorted(t_SampleHistory * history, uint16_t sample)
+{
+    uint8_t i = 0;
+    while ((i < history->count) && (history->sorted[i] != sample))
+        i++;
+
+    for (; (i + 1) < history->count; i++)
+        history->sorted[i] = history->sorted[i + 1];
+}
+
+static void SampleHistory_insertSorted(t_SampleHistory * history, uint8_t count, uint16_t sample)
+{
+    uint8_t i = count;
+    while ((i > 0) && (history->sorted[i - 1] > sample))
+    {
+        history->sorted[i] = history->sorted[i - 1];
+        i--;
+    }
+
+    history->sorted[i] = sample;
+}
+
+void SampleHistory_add(t_SampleHistory * history, uint16_t sample)
+{
+    if (history->count < history->window)
+    {
+        history->samples[(history->head + history->count) % history->window] = sample;
+        SampleHistory_insertSorted(history, history->count, sample);
+        history->count++;
+        return;
+    }
+
+    /* Full: the new sample takes the slot of the oldest one */
+    SampleHistory_removeSorted(history, history->samples[history->head]);
+    SampleHistory_insertSorted(history, history->count - 1, sample);
+
+    history->samples[history->head] = sample;
+    history->head = (history->head + 1) % history->window;
+}
+
+uint16_t SampleHistory_median(const t_SampleHistory * history)
+{
+    if (history->count == 0)
+        return 0;
+
+    /* Even count: lower middle, a value that was actually read */
+    return history->sorted[(history->count - 1) / 2];
+}
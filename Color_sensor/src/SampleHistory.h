@@ -0,0 +1,42 @@
+#ifndef SAMPLEHISTORY_H
+#define SAMPLEHISTORY_H
+
+#include <stdint.h>
+
+/* Largest rolling median window */
+#define SAMPLE_HISTORY_SIZE 8
+
+/* Last samples of one sensor channel, with rolling median
+ *
+ */
+typedef struct
+{
+    uint16_t samples[SAMPLE_HISTORY_SIZE]; /* Ring, oldest at head */
+    uint16_t sorted[SAMPLE_HISTORY_SIZE];  /* Same samples in ascending order */
+    uint8_t window;                        /* Samples kept, 1 to SAMPLE_HISTORY_SIZE */
+    uint8_t head;
+    uint8_t count;
+} t_SampleHistory;
+
+/* Reset a history to empty state
+ *
+ * input: pointer to history, median window (samples)
+ * output: none
+ */
+void SampleHistory_init(t_SampleHistory * history, uint8_t window);
+
+/* Add a sample, dropping the oldest one once the window is full
+ *
+ * input: pointer to history, sample
+ * output: none
+ */
+void SampleHistory_add(t_SampleHistory * history, uint16_t sample);
+
+/* Get median of samples in window
+ *
+ * input: pointer to history
+ * output: median, 0 if empty
+ */
+uint16_t SampleHistory_median(const t_SampleHistory * history);
+
+#endif /* SAMPLEHISTORY_H */
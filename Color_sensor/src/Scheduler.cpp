@@ -0,0 +1,144 @@
+#include "Scheduler.h"
+
+void Scheduler_init(t_Scheduler * scheduler)
+{
+    scheduler->count = 0;
+    scheduler->owner = nullptr;
+}
+
+int8_t Scheduler_add(t_Scheduler * scheduler, const char * name, t_SchedulerJob job, uint32_t period, uint32_t budget)
+{
+    if (scheduler->count >= SCHEDULER_MAX_JOBS)
+        return -1;
+
+    t_SchedulerEntry * entry = &scheduler->jobs[scheduler->count];
+    entry->name = name;
+    entry->job = job;
+    entry->period = period;
+    entry->budget = budget;
+    entry->nextRun = millis();
+    entry->pending = false;
+    entry->stats = {0, 0, 0, 0, 0};
+
+    return (int8_t)(scheduler->count++);
+}
+
+void Scheduler_signal(t_Scheduler * scheduler, int8_t id)
+{
+    if ((id < 0) || (id >= scheduler->count))
+        return;
+
+    scheduler->jobs[id].pending = true;
+    if (scheduler->owner != nullptr)
+        xTaskNotifyGive(scheduler->owner);
+}
+
+void IRAM_ATTR Scheduler_signalFromIsr(t_Scheduler * scheduler, int8_t id)
+{
+    if ((id < 0) || (id >= scheduler->count))
+        return;
+
+    BaseType_t woken = pdFALSE;
+
+    scheduler->jobs[id].pending = true;
+    if (scheduler->owner != nullptr)
+        vTaskNotifyGiveFromISR(scheduler->owner, &woken);
+
+    if (woken == pdTRUE)
+        portYIELD_FROM_ISR();
+}
+
+void Scheduler_setNextRun(t_Scheduler * scheduler, int8_t id, uint32_t delay)
+{
+    if ((id < 0) || (id >= scheduler->count))
+        return;
+
+    scheduler->jobs[id].nextRun = millis() + delay;
+}
+
+static void Scheduler_execute(t_SchedulerEntry * entry)
+{
+    uint32_t start = micros();
+    entry->job();
+    uint32_t duration = micros() - start;
+
+    t_SchedulerStats * stats = &entry->stats;
+    stats->runs++;
+    stats->lastDuration = duration;
+    stats->totalDuration += duration;
+    if (duration > stats->maxDuration)
+        stats->maxDuration = duration;
+
+    if (duration > entry->budget)
+    {
+        stats->overruns++;
+        Serial.printf("Job %s overrun: %u us\n", entry->name, duration);
+    }
+}
+
+void Scheduler_run(t_Scheduler * scheduler)
+{
+    if (scheduler->owner == nullptr)
+        scheduler->owner = xTaskGetCurrentTaskHandle();
+
+    for (uint8_t i = 0; i < scheduler->count; i++)
+    {
+        t_SchedulerEntry * entry = &scheduler->jobs[i];
+        bool due = (entry->period > 0) && ((int32_t)(millis() - entry->nextRun) >= 0);
+
+        if (!due && !entry->pending)
+            continue;
+
+        entry->pending = false;
+        if (due)
+        {
+            /* Keep the cadence, skip periods missed by a long overrun */
+            entry->nextRun += entry->period;
+            if ((int32_t)(millis() - entry->nextRun) >= 0)
+                entry->nextRun = millis() + entry->period;
+        }
+
+        Scheduler_execute(entry);
+    }
+
+    /* Sleep until the earliest deadline, an event wakes up sooner */
+    uint32_t now = millis();
+    uint32_t sleep = portMAX_DELAY;
+
+    for (uint8_t i = 0; i < scheduler->count; i++)
+    {
+        const t_SchedulerEntry * entry = &scheduler->jobs[i];
+        if (entry->pending)
+            sleep = 0;
+        else if (entry->period > 0)
+        {
+            int32_t remaining = (int32_t)(entry->nextRun - now);
+            if (remaining < 0)
+                remaining = 0;
+            if ((uint32_t)remaining < sleep)
+                sleep = (uint32_t)remaining;
+        }
+    }
+
+    /* At least one tick, so lower priority tasks (and idle watchdog) get to run */
+    TickType_t ticks = (sleep == portMAX_DELAY) ? portMAX_DELAY : pdMS_TO_TICKS(sleep);
+    if (ticks == 0)
+        ticks = 1;
+
+    (void)ulTaskNotifyTake(pdTRUE, ticks);
+}
+
+void Scheduler_printStats(const t_Scheduler * scheduler, const char * name)
+{
+    Serial.printf("Scheduler %s:\n", name);
+
+    for (uint8_t i = 0; i < scheduler->count; i++)
+    {
+        const t_SchedulerEntry * entry = &scheduler->jobs[i];
+        const t_SchedulerStats * stats = &entry->stats;
+        uint32_t average = (stats->runs > 0) ? (uint32_t)(stats->totalDuration / stats->runs) : 0;
+
+        Serial.printf("  %-10s runs %u, avg %u us, max %u us, overruns %u (budget %u us)\n",
+                entry->name, stats->runs, average, stats->maxDuration, stats->overruns, entry->budget);
+    }
+}
@@ -0,0 +1,101 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+/* Jobs one scheduler can hold */
+#define SCHEDULER_MAX_JOBS 8
+
+/* Function prototype of a scheduled job,
+ * it must return within its budget and never wait
+ */
+typedef void (* t_SchedulerJob)(void);
+
+/* Execution counters of a job, durations in microseconds
+ *
+ */
+typedef struct
+{
+    uint32_t runs;
+    uint32_t overruns;      /* Runs longer than the budget */
+    uint32_t lastDuration;
+    uint32_t maxDuration;
+    uint64_t totalDuration;
+} t_SchedulerStats;
+
+typedef struct
+{
+    const char * name;
+    t_SchedulerJob job;
+    uint32_t period;        /* Milliseconds, 0 for event-driven only */
+    uint32_t budget;        /* Microseconds */
+    uint32_t nextRun;       /* millis() of next periodic run */
+    volatile bool pending;  /* Event signaled, run as soon as possible */
+    t_SchedulerStats stats;
+} t_SchedulerEntry;
+
+/* Cooperative scheduler of one FreeRTOS task: runs jobs when their
+ * period elapsed or their event was signaled, and sleeps until the
+ * next deadline or event in between
+ *
+ */
+typedef struct
+{
+    t_SchedulerEntry jobs[SCHEDULER_MAX_JOBS];
+    uint8_t count;
+    TaskHandle_t owner; /* Task running the scheduler, woken up by events */
+} t_Scheduler;
+
+/* Reset a scheduler to have no job
+ *
+ * input: pointer to scheduler
+ * output: none
+ */
+void Scheduler_init(t_Scheduler * scheduler);
+
+/* Register a job, jobs run in order of registration when due together
+ *
+ * input: pointer to scheduler, name, job function,
+ *        period in milliseconds (0 = only on event), time budget in microseconds
+ * output: job id, -1 if the scheduler is full
+ */
+int8_t Scheduler_add(t_Scheduler * scheduler, const char * name, t_SchedulerJob job, uint32_t period, uint32_t budget);
+
+/* Request a job to run as soon as possible (task context)
+ *
+ * input: pointer to scheduler, job id
+ * output: none
+ */
+void Scheduler_signal(t_Scheduler * scheduler, int8_t id);
+
+/* Request a job to run as soon as possible (interrupt context)
+ *
+ * input: pointer to scheduler, job id
+ * output: none
+ */
+void Scheduler_signalFromIsr(t_Scheduler * scheduler, int8_t id);
+
+/* Move the next periodic run of a job, e.g. by the job itself when it
+ * knows its next deadline (task owning the scheduler only)
+ *
+ * input: pointer to scheduler, job id, milliseconds from now
+ * output: none
+ */
+void Scheduler_setNextRun(t_Scheduler * scheduler, int8_t id, uint32_t delay);
+
+/* Run due jobs then sleep until next deadline or event,
+ * to be called in a loop by the task owning the scheduler
+ *
+ * input: pointer to scheduler
+ * output: none
+ */
+void Scheduler_run(t_Scheduler * scheduler);
+
+/* Print execution counters of every job
+ *
+ * input: pointer to scheduler, name of scheduler
+ * output: none
+ */
+void Scheduler_printStats(const t_Scheduler * scheduler, const char * name);
+
+#endif /* SCHEDULER_H */
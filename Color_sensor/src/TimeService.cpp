@@ -0,0 +1,122 @@
+#include <Arduino.h>
+#include <sys/time.h>
+#include <esp_timer.h>
+#include <esp_sntp.h>
+
+#include "TimeService.h"
+
+#define TIME_NTP_SERVER "pool.ntp.org"
+
+/* GMT+7 offset in seconds (Hanoi) */
+#define TIME_GMT_OFFSET (7 * 60 * 60)
+
+/* System time below this (2021-01-01) has never been set */
+#define TIME_VALID_EPOCH 1609459200
+
+/* Wall-clock time at a monotonic timer value, taken at each SNTP update */
+static bool TimeService_anchored = false;
+static uint64_t TimeService_anchorEpochMs = 0;
+static int64_t TimeService_anchorUs = 0;
+static uint64_t TimeService_lastNowMs = 0; /* Latest time returned */
+
+static t_TimeSyncInfo TimeService_info = {false, 0, 0, 0, 0};
+
+/* Last rendered date */
+static uint32_t TimeService_dateEpoch = 0;
+static char TimeService_date[TIME_DATE_LENGTH] = "";
+
+void TimeService_init(void)
+{
+    configTime(TIME_GMT_OFFSET, 0, TIME_NTP_SERVER);
+    Serial.println("Time sync, GMT+7 (Hanoi)");
+}
+
+void TimeService_task(void)
+{
+    /* Reported once per update, then back to reset.
+     * First anchor also taken if the status was consumed elsewhere */
+    bool updated = (sntp_get_sync_status() == SNTP_SYNC_STATUS_COMPLETED);
+    if (!updated && (TimeService_anchored || (time(nullptr) < TIME_VALID_EPOCH)))
+        return;
+
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+
+    int64_t nowUs = esp_timer_get_time();
+    uint64_t epochMs = ((uint64_t)now.tv_sec * 1000) + (now.tv_usec / 1000);
+
+    if (TimeService_anchored)
+    {
+        /* Compare with the time our anchor predicts */
+        int64_t elapsedMs = (nowUs - TimeService_anchorUs) / 1000;
+        int64_t correction = (int64_t)(epochMs - (TimeService_anchorEpochMs + elapsedMs));
+
+        TimeService_info.lastCorrection = (int32_t)correction;
+        if (elapsedMs > 0)
+            TimeService_info.drift = (int32_t)((correction * 1000000) / elapsedMs);
+    }
+
+    TimeService_anchorEpochMs = epochMs;
+    TimeService_anchorUs = nowUs;
+    TimeService_anchored = true;
+
+    TimeService_info.synced = true;
+    TimeService_info.syncCount++;
+
+    Serial.printf("Time synced: %s (correction %d ms)\n", TimeService_formatDate((uint32_t)(epochMs / 1000)),
+            TimeService_info.lastCorrection);
+}
+
+bool TimeService_isSynced(void)
+{
+    return TimeService_anchored;
+}
+
+uint64_t TimeService_nowMs(void)
+{
+    if (!TimeService_anchored)
+        return 0;
+
+    uint64_t now = TimeService_anchorEpochMs + (uint64_t)((esp_timer_get_time() - TimeService_anchorUs) / 1000);
+    if (now < TimeService_lastNowMs)
+        return TimeService_lastNowMs;
+
+    TimeService_lastNowMs = now;
+    return now;
+}
+
+uint64_t TimeService_epochMsAt(uint32_t timestamp)
+{
+    if (!TimeService_anchored)
+        return 0;
+
+    return TimeService_nowMs() - (millis() - timestamp);
+}
+
+const char * TimeService_formatDate(uint32_t epoch)
+{
+    if ((epoch == TimeService_dateEpoch) && (TimeService_date[0] != '\0'))
+        return TimeService_date;
+
+    time_t seconds = (time_t)epoch;
+    struct tm local;
+    localtime_r(&seconds, &local);
+
+    int length = snprintf(TimeService_date, sizeof(TimeService_date), "%d/%d/%d %02d:%02d:%02d",
+            local.tm_mday, local.tm_mon + 1, local.tm_year + 1900, local.tm_hour, local.tm_min, local.tm_sec);
+
+    /* Only a broken calendar overflows, rendered again on next call */
+    if ((length < 0) || ((size_t)length >= sizeof(TimeService_date)))
+        TimeService_date[0] = '\0';
+
+    TimeService_dateEpoch = epoch;
+    return TimeService_date;
+}
+
+void TimeService_getSyncInfo(t_TimeSyncInfo * info)
+{
+    *info = TimeService_info;
+
+    if (TimeService_anchored)
+        info->lastSyncAge = (uint32_t)((esp_timer_get_time() - TimeService_anchorUs) / 1000);
+}
@@ -0,0 +1,75 @@
+#ifndef TIMESERVICE_H
+#define TIMESERVICE_H
+
+#include <stdint.h>
+
+/* Length of a formatted date "d/m/yyyy hh:mm:ss" (day and month not padded) including terminator */
+#define TIME_DATE_LENGTH 24
+
+/* Synchronization quality
+ *
+ */
+typedef struct
+{
+    bool synced;             /* Anchored to SNTP at least once */
+    uint32_t syncCount;      /* SNTP updates received */
+    uint32_t lastSyncAge;    /* Milliseconds since last SNTP update */
+    int32_t lastCorrection;  /* Milliseconds the clock was off at last update (SNTP - local) */
+    int32_t drift;           /* Local clock drift measured between the last two updates, ppm */
+} t_TimeSyncInfo;
+
+/* Start SNTP synchronization, returns immediately,
+ * time becomes valid after the first update (see TimeService_isSynced())
+ *
+ * input: none
+ * output: none
+ */
+void TimeService_init(void);
+
+/* Periodic task handler to take SNTP updates as new anchor,
+ * never blocks. Call it from the task that reads the time
+ *
+ * input: none
+ * output: none
+ */
+void TimeService_task(void);
+
+/* Check whether wall-clock time is valid
+ *
+ * input: none
+ * output: true once anchored to SNTP
+ */
+bool TimeService_isSynced(void);
+
+/* Get wall-clock time derived from the monotonic timer, never blocks.
+ * An update that sets the clock back holds the time until it has caught up,
+ * so it never decreases
+ *
+ * input: none
+ * output: milliseconds since epoch, 0 while not synced
+ */
+uint64_t TimeService_nowMs(void);
+
+/* Convert a millis() timestamp of the past to wall-clock time
+ *
+ * input: millis() value
+ * output: milliseconds since epoch, 0 while not synced
+ */
+uint64_t TimeService_epochMsAt(uint32_t timestamp);
+
+/* Format a wall-clock time as local date "d/m/yyyy hh:mm:ss",
+ * rendered again only when the second changes
+ *
+ * input: seconds since epoch
+ * output: pointer to the cached string, valid until next call
+ */
+const char * TimeService_formatDate(uint32_t epoch);
+
+/* Get synchronization quality
+ *
+ * input: pointer to a buffer that receives the information
+ * output: none
+ */
+void TimeService_getSyncInfo(t_TimeSyncInfo * info);
+
+#endif /* TIMESERVICE_H */
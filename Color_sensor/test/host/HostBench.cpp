@@ -0,0 +1,87 @@
+#include <stddef.h>
+#include <chrono>
+
+#include "HostBench.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define HOST_BENCH_RUNS 5
+
+static volatile uint32_t HostBench_sink;
+static uint32_t HostBench_allocationCount = 0;
+
+/* glibc allocator behind counting wrappers (operator new calls malloc) */
+extern "C" void * __libc_malloc(size_t size);
+extern "C" void * __libc_calloc(size_t count, size_t size);
+extern "C" void * __libc_realloc(void * pointer, size_t size);
+extern "C" void __libc_free(void * pointer);
+
+extern "C" void * malloc(size_t size)
+{
+    HostBench_allocationCount++;
+    return __libc_malloc(size);
+}
+
+extern "C" void * calloc(size_t count, size_t size)
+{
+    HostBench_allocationCount++;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void * realloc(void * pointer, size_t size)
+{
+    HostBench_allocationCount++;
+    return __libc_realloc(pointer, size);
+}
+
+extern "C" void free(void * pointer)
+{
+    __libc_free(pointer);
+}
+
+uint64_t HostBench_now(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+const char * HostBench_unit(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return "cycles";
+#else
+    return "ns";
+#endif
+}
+
+double HostBench_perCall(t_HostBenchFunction function, uint32_t calls)
+{
+    uint64_t best = UINT64_MAX;
+
+    for (uint32_t run = 0; run < HOST_BENCH_RUNS; run++)
+    {
+        uint64_t start = HostBench_now();
+        function(calls);
+        uint64_t elapsed = HostBench_now() - start;
+        if (elapsed < best)
+            best = elapsed;
+    }
+
+    return (double)best / calls;
+}
+
+uint32_t HostBench_allocations(void)
+{
+    return HostBench_allocationCount;
+}
+
+void HostBench_use(uint32_t value)
+{
+    HostBench_sink = HostBench_sink + value;
+}
@@ -0,0 +1,36 @@
+#ifndef HOSTBENCH_H
+#define HOSTBENCH_H
+
+#include <stdint.h>
+
+/* Timing of the host benchmarks (bench_*.cpp, `make bench`).
+ * Host numbers compare two versions of a kernel, they are not
+ * the cycle counts of the ESP32
+ */
+
+/* Kernel under measurement, runs it the given number of times */
+typedef void (* t_HostBenchFunction)(uint32_t calls);
+
+/* Time stamp: TSC cycles on x86, nanoseconds of the steady clock elsewhere */
+uint64_t HostBench_now(void);
+
+/* Unit of HostBench_now(), "cycles" or "ns" */
+const char * HostBench_unit(void);
+
+/* Time per call of a kernel, best of a few runs so that
+ * interrupts and frequency changes of the host drop out
+ *
+ * input: kernel, calls per run
+ * output: HostBench_now() units per call
+ */
+double HostBench_perCall(t_HostBenchFunction function, uint32_t calls);
+
+/* Heap allocations (malloc, calloc, realloc, operator new) since start,
+ * the difference around a call is what the call allocated
+ */
+uint32_t HostBench_allocations(void);
+
+/* Keep a result alive so the compiler does not drop the kernel */
+void HostBench_use(uint32_t value);
+
+#endif /* HOSTBENCH_H */
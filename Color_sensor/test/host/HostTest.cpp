@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <vector>
+
+#include "HostTest.h"
+
+typedef struct
+{
+    const char * name;
+    t_HostTestFunction function;
+} t_HostTest;
+
+static std::vector<t_HostTest> & HostTest_tests(void)
+{
+    static std::vector<t_HostTest> tests;
+    return tests;
+}
+
+HostTest_Registrar::HostTest_Registrar(const char * name, t_HostTestFunction function)
+{
+    HostTest_tests().push_back({name, function});
+}
+
+void HostTest_fail(const char * file, int line, const char * text)
+{
+    fprintf(stderr, "%s:%d: check failed: %s\n", file, line, text);
+    fflush(stdout);
+    _exit(1);
+}
+
+void HostTest_failValues(const char * file, int line, const char * text, long long actual, long long expected)
+{
+    fprintf(stderr, "%s:%d: check failed: %s (%lld, expected %lld)\n", file, line, text, actual, expected);
+    fflush(stdout);
+    _exit(1);
+}
+
+bool HostTest_runChild(t_HostTestFunction function)
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        function();
+        fflush(stdout);
+        _exit(0);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+}
+
+int HostTest_run(const char * filter)
+{
+    uint32_t passed = 0, failed = 0;
+
+    for (const t_HostTest & test : HostTest_tests())
+    {
+        if ((filter != nullptr) && (strstr(test.name, filter) == nullptr))
+            continue;
+
+        bool ok = HostTest_runChild(test.function);
+        printf("[%s] %s\n", ok ? "PASS" : "FAIL", test.name);
+        if (ok)
+            passed++;
+        else
+            failed++;
+    }
+
+    printf("%u passed, %u failed\n", passed, failed);
+    return (failed == 0) ? 0 : 1;
+}
+
+int main(int argc, char ** argv)
+{
+    return HostTest_run((argc > 1) ? argv[1] : nullptr);
+}
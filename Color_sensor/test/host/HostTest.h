@@ -0,0 +1,50 @@
+#ifndef HOSTTEST_H
+#define HOSTTEST_H
+
+#include <stdint.h>
+
+/* Minimal test runner for the host build: every test runs
+ * in its own process, so static state of the sketch sources
+ * starts from scratch as after a reset of the board
+ */
+
+typedef void (* t_HostTestFunction)(void);
+
+struct HostTest_Registrar
+{
+    HostTest_Registrar(const char * name, t_HostTestFunction function);
+};
+
+#define TEST(name) \
+    static void name(void); \
+    static HostTest_Registrar name##_registrar(#name, name); \
+    static void name(void)
+
+void HostTest_fail(const char * file, int line, const char * text);
+void HostTest_failValues(const char * file, int line, const char * text, long long actual, long long expected);
+
+#define CHECK(condition) \
+    do { if (!(condition)) HostTest_fail(__FILE__, __LINE__, #condition); } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    do { long long a_ = (long long)(actual), e_ = (long long)(expected); \
+        if (a_ != e_) HostTest_failValues(__FILE__, __LINE__, #actual " == " #expected, a_, e_); } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+    do { long long a_ = (long long)(actual), e_ = (long long)(expected); \
+        if ((a_ > e_ + (long long)(tolerance)) || (a_ < e_ - (long long)(tolerance))) \
+            HostTest_failValues(__FILE__, __LINE__, #actual " ~ " #expected, a_, e_); } while (0)
+
+/* Run a function in a child process, e.g. a boot of the board
+ * before the one under test (a fresh process has fresh static state)
+ *
+ * output: true if the function returned without a failed check
+ */
+bool HostTest_runChild(t_HostTestFunction function);
+
+/* Run the registered tests whose name contains filter (all if nullptr)
+ * output: process exit status, 0 if all passed
+ */
+int HostTest_run(const char * filter);
+
+#endif /* HOSTTEST_H */
@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "ColorClassifier.h"
+#include "HostBench.h"
+
+/* Lookup table classifier against the exact (brute-force) one:
+ * class agreement over every color, time per call over uniform
+ * colors and over colors of objects (taught colors plus noise)
+ */
+
+#define BENCH_CALLS 1000000
+#define BENCH_OBJECT_NOISE 12
+
+static std::vector<t_Color> Bench_colors;
+
+static void Bench_lut(uint32_t calls)
+{
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < calls; i++)
+    {
+        t_Color color = Bench_colors[i % Bench_colors.size()];
+        ColorClassifier_classify(&color);
+        sum += color.classId;
+    }
+    HostBench_use(sum);
+}
+
+static void Bench_exact(uint32_t calls)
+{
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < calls; i++)
+    {
+        t_Color color = Bench_colors[i % Bench_colors.size()];
+        ColorClassifier_classifyExact(&color);
+        sum += color.classId;
+    }
+    HostBench_use(sum);
+}
+
+static uint8_t Bench_noisy(uint8_t value)
+{
+    int noisy = value + (rand() % (2 * BENCH_OBJECT_NOISE + 1)) - BENCH_OBJECT_NOISE;
+    return (uint8_t)((noisy < 0) ? 0 : ((noisy > 255) ? 255 : noisy));
+}
+
+static void Bench_time(const char * inputs)
+{
+    double lut = HostBench_perCall(Bench_lut, BENCH_CALLS);
+    double exact = HostBench_perCall(Bench_exact, BENCH_CALLS);
+    printf("%-8s lookup %6.1f %s/call, exact %6.1f %s/call, %.1fx\n",
+            inputs, lut, HostBench_unit(), exact, HostBench_unit(), exact / lut);
+}
+
+int main(void)
+{
+    ColorClassifier_init();
+
+    uint32_t agree = 0, total = 0;
+    for (uint32_t rgb = 0; rgb < (1U << 24); rgb++)
+    {
+        t_Color lut = {(uint8_t)(rgb >> 16), (uint8_t)(rgb >> 8), (uint8_t)rgb, 0, 0, 0};
+        t_Color exact = lut;
+        ColorClassifier_classify(&lut);
+        ColorClassifier_classifyExact(&exact);
+        agree += (lut.classId == exact.classId) ? 1 : 0;
+        total++;
+    }
+    printf("class agreement with exact: %u of %u colors (%.3f %%)\n", agree, total, (100.0 * agree) / total);
+
+    srand(1);
+    for (uint32_t i = 0; i < 65536; i++)
+        Bench_colors.push_back({(uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand(), 0, 0, 0});
+    Bench_time("uniform");
+
+    /* Taught colors of ColorClassifier.cpp */
+    static const uint8_t objects[][3] = {{200, 30, 25}, {40, 160, 55}, {30, 70, 155}, {140, 105, 10}, {85, 85, 85}, {20, 20, 20}};
+    Bench_colors.clear();
+    for (uint32_t i = 0; i < 65536; i++)
+    {
+        const uint8_t * object = objects[i % 6];
+        Bench_colors.push_back({Bench_noisy(object[0]), Bench_noisy(object[1]), Bench_noisy(object[2]), 0, 0, 0});
+    }
+    Bench_time("objects");
+
+    return (agree == total) ? 0 : 1;
+}
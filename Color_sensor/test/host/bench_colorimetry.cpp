@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+#include "Lib/Adafruit_TCS34725/Adafruit_TCS34725.h"
+#include "HostBench.h"
+
+/* Fixed-point normalizeRGB() of the TCS34725 driver, used by the
+ * sampling path, against its float version: largest difference over
+ * random samples and time per call. Exit status is 1 if the difference
+ * is beyond the bound documented with the kernel
+ */
+
+#define BENCH_SAMPLES 2000000
+#define BENCH_CALLS 1000000
+
+/* Bound of the fixed-point kernel (Adafruit_TCS34725.cpp), LSB of the 8-bit channel */
+#define BENCH_RGB_BOUND 1
+
+typedef struct
+{
+    uint16_t red, green, blue, clear;
+} t_BenchSample;
+
+static Adafruit_TCS34725 Bench_sensor;
+static std::vector<t_BenchSample> Bench_samples;
+
+/* Raw sample: clear up to full scale, each channel at most the clear count */
+static t_BenchSample Bench_randomSample(void)
+{
+    uint16_t clear = (uint16_t)(1 + (rand() % 65535));
+    return {(uint16_t)(rand() % (clear + 1)), (uint16_t)(rand() % (clear + 1)), (uint16_t)(rand() % (clear + 1)), clear};
+}
+
+static void Bench_normalizeFloat(uint32_t calls)
+{
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < calls; i++)
+    {
+        const t_BenchSample & s = Bench_samples[i % Bench_samples.size()];
+        float r, g, b;
+        Bench_sensor.normalizeRGB(s.red, s.green, s.blue, s.clear, &r, &g, &b);
+        sum += (uint8_t)r + (uint8_t)g + (uint8_t)b;
+    }
+    HostBench_use(sum);
+}
+
+static void Bench_normalizeFixed(uint32_t calls)
+{
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < calls; i++)
+    {
+        const t_BenchSample & s = Bench_samples[i % Bench_samples.size()];
+        uint8_t r, g, b;
+        Bench_sensor.normalizeRGB(s.red, s.green, s.blue, s.clear, &r, &g, &b);
+        sum += r + g + b;
+    }
+    HostBench_use(sum);
+}
+
+static bool Bench_report(const char * name, t_HostBenchFunction floatVersion, t_HostBenchFunction fixedVersion,
+        uint32_t compared, uint32_t maxError, uint32_t bound)
+{
+    double floatTime = HostBench_perCall(floatVersion, BENCH_CALLS);
+    double fixedTime = HostBench_perCall(fixedVersion, BENCH_CALLS);
+    printf("%-14s max error %3u (bound %2u) over %7u samples, float %5.1f %s/call, fixed %5.1f %s/call\n",
+            name, maxError, bound, compared, floatTime, HostBench_unit(), fixedTime, HostBench_unit());
+    return maxError <= bound;
+}
+
+int main(void)
+{
+    srand(1);
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+        Bench_samples.push_back(Bench_randomSample());
+
+    uint32_t rgbError = 0;
+
+    for (const t_BenchSample & s : Bench_samples)
+    {
+        float rf, gf, bf;
+        uint8_t r, g, b;
+        Bench_sensor.normalizeRGB(s.red, s.green, s.blue, s.clear, &rf, &gf, &bf);
+        Bench_sensor.normalizeRGB(s.red, s.green, s.blue, s.clear, &r, &g, &b);
+        rgbError = std::max(rgbError, (uint32_t)abs((int)(uint8_t)rf - r));
+        rgbError = std::max(rgbError, (uint32_t)abs((int)(uint8_t)gf - g));
+        rgbError = std::max(rgbError, (uint32_t)abs((int)(uint8_t)bf - b));
+    }
+
+    bool ok = Bench_report("normalizeRGB", Bench_normalizeFloat, Bench_normalizeFixed, BENCH_SAMPLES, rgbError, BENCH_RGB_BOUND);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,136 @@
+#include <time.h>
+
+/* The batch serializer is static, build it into this file
+ * (shadow copy, so the Firebase client is the fake one) */
+#include "build/shadow/FirebaseDb.cpp"
+
+#include "FakeArduino.h"
+#include "FakeTime.h"
+#include "HostBench.h"
+#include "Lib/Firebase_ESP32_Client/src/json/MB_String.h"
+
+extern "C"
+{
+#include "Lib/Firebase_ESP32_Client/src/json/MB_JSON/MB_JSON.h"
+}
+
+/* Serialization of one upload batch, allocations and time:
+ *
+ * before: String temporaries and a FirebaseJson tree per record, printed
+ *         into the request payload (the record builder of the String version,
+ *         with the tree built by MB_JSON, the parser under FirebaseJson)
+ * after:  Database_serializeBatch() into the static upload buffer
+ *
+ * Both end with the client copying the payload into its request (an
+ * MB_String). FirebaseJson itself does not build on a 64-bit host (it keeps
+ * addresses in uint32_t), so "before" leaves out its path parsing and is
+ * a lower bound. Host String and std::string keep up to 15 characters
+ * without allocation, the ESP32 String about 11: host counts are close
+ * to the board's, not equal
+ */
+
+#define BENCH_CALLS 20000
+
+/* Record builder of the String version, tree calls in place of FirebaseJson::set() */
+static void Bench_addObject(MB_JSON * update, const t_ObjectRecord * object)
+{
+    const t_Color * objectColor = &object->color;
+    String objectColorValue = String(objectColor->red) + "," + String(objectColor->green) + "," + String(objectColor->blue);
+
+    time_t now = (time_t)object->epoch;
+    struct tm timeStamp;
+    localtime_r(&now, &timeStamp);
+
+    String hh = (timeStamp.tm_hour < 10 ? "0" : "") + String(timeStamp.tm_hour);
+    String mm = (timeStamp.tm_min < 10 ? "0" : "") + String(timeStamp.tm_min);
+    String ss = (timeStamp.tm_sec < 10 ? "0" : "") + String(timeStamp.tm_sec);
+
+    String objectDetectionTime = String(timeStamp.tm_mday) + "/" + String((timeStamp.tm_mon) + 1) + "/" + String((timeStamp.tm_year) + 1900) +
+            " " + hh + ":" + mm + ":" + ss;
+
+    String key = String(object->key);
+    String userPath = key + "/user";
+    String statusPath = key + "/status";
+    String colorPath = key + "/color";
+    String timePath = key + "/timestamp";
+
+    MB_JSON * record = MB_JSON_CreateObject();
+    MB_JSON_AddItemToObject(update, key.c_str(), record);
+    MB_JSON_AddItemToObject(record, "user", MB_JSON_CreateString(""));
+    MB_JSON_AddItemToObject(record, "status", MB_JSON_CreateString("0"));
+    MB_JSON_AddItemToObject(record, "color", MB_JSON_CreateString(objectColorValue.c_str()));
+    MB_JSON_AddItemToObject(record, "timestamp", MB_JSON_CreateString(objectDetectionTime.c_str()));
+}
+
+static size_t Bench_payloadLength;
+
+static void Bench_before(uint32_t calls)
+{
+    for (uint32_t call = 0; call < calls; call++)
+    {
+        MB_JSON * update = MB_JSON_CreateObject();
+        for (uint32_t i = 0; i < DATABASE_UPLOAD_BATCH; i++)
+            Bench_addObject(update, DetectionQueue_peekAt(&uploadQueue, i));
+
+        char * printed = MB_JSON_PrintUnformatted(update);
+        MB_String payload = printed;
+        MB_String request = payload;
+        Bench_payloadLength = request.length();
+
+        MB_JSON_free(printed);
+        MB_JSON_Delete(update);
+    }
+}
+
+static void Bench_after(uint32_t calls)
+{
+    const t_ObjectRecord * records[DATABASE_UPLOAD_BATCH];
+    for (uint32_t i = 0; i < DATABASE_UPLOAD_BATCH; i++)
+        records[i] = DetectionQueue_peekAt(&uploadQueue, i);
+
+    for (uint32_t call = 0; call < calls; call++)
+    {
+        HostBench_use(Database_serializeBatch(records, DATABASE_UPLOAD_BATCH));
+        MB_String request = (const char *)uploadBuffer;
+        Bench_payloadLength = request.length();
+    }
+}
+
+static void Bench_report(const char * name, t_HostBenchFunction function)
+{
+    uint32_t allocations = HostBench_allocations();
+    function(1);
+    allocations = HostBench_allocations() - allocations;
+
+    double time = HostBench_perCall(function, BENCH_CALLS);
+    printf("%-16s %4u allocations, %8.0f %s, %4zu bytes of payload per batch of %u\n",
+            name, allocations, time, HostBench_unit(), Bench_payloadLength, DATABASE_UPLOAD_BATCH);
+}
+
+int main(void)
+{
+    Fake_reset();
+    FakeTime_set(1700000000000ULL);
+
+    for (uint32_t i = 0; i < DATABASE_UPLOAD_BATCH; i++)
+    {
+        t_ObjectRecord record;
+        memset(&record, 0, sizeof(record));
+        record.sequence = i;
+        record.epoch = 1700000000 + (i * 7);
+        record.epochMs = (uint16_t)(i * 125);
+        record.color = {(uint8_t)(100 + i), 50, 40, 3000, COLOR_CLASS_NONE, 0};
+        RecordKey_generate(((uint64_t)record.epoch * 1000) + record.epochMs, record.key);
+        DetectionQueue_push(&uploadQueue, &record);
+    }
+
+    Bench_report("before", Bench_before);
+
+    uploadSchema = DATABASE_SCHEMA_LEGACY;
+    Bench_report("after (legacy)", Bench_after);
+
+    uploadSchema = DATABASE_SCHEMA_COMPACT;
+    Bench_report("after (compact)", Bench_after);
+
+    return 0;
+}
@@ -0,0 +1,257 @@
+#include "FakeArduino.h"
+
+#define FAKE_PIN_COUNT 40
+
+HardwareSerial Serial;
+HardwareSerial Serial2;
+EspClass ESP;
+
+static uint64_t Fake_time = 0;
+static std::function<void(uint64_t)> Fake_tickHook;
+static int Fake_pinLevel[FAKE_PIN_COUNT];
+static void (* Fake_isr[FAKE_PIN_COUNT])(void);
+static int Fake_isrMode[FAKE_PIN_COUNT];
+static bool Fake_log = (getenv("HOST_TEST_VERBOSE") != nullptr);
+static uint32_t Fake_randomState = 0x12345678;
+
+void Fake_reset(void)
+{
+    Fake_time = 0;
+    Fake_tickHook = nullptr;
+
+    for (uint8_t pin = 0; pin < FAKE_PIN_COUNT; pin++)
+    {
+        Fake_pinLevel[pin] = HIGH;
+        Fake_isr[pin] = nullptr;
+        Fake_isrMode[pin] = 0;
+    }
+
+    Serial = HardwareSerial();
+    Serial2 = HardwareSerial();
+}
+
+uint64_t Fake_micros(void)
+{
+    return Fake_time;
+}
+
+void Fake_advance(uint32_t us)
+{
+    Fake_time += us;
+    if (Fake_tickHook)
+        Fake_tickHook(Fake_time);
+}
+
+void Fake_setTickHook(std::function<void(uint64_t)> hook)
+{
+    Fake_tickHook = hook;
+}
+
+void Fake_setPin(uint8_t pin, int level)
+{
+    if (pin >= FAKE_PIN_COUNT)
+        return;
+
+    int previous = Fake_pinLevel[pin];
+    Fake_pinLevel[pin] = level;
+
+    if ((Fake_isr[pin] == nullptr) || (previous == level))
+        return;
+
+    bool falling = (level == LOW);
+    if ((Fake_isrMode[pin] == CHANGE) || ((Fake_isrMode[pin] == FALLING) && falling) || ((Fake_isrMode[pin] == RISING) && !falling))
+        Fake_isr[pin]();
+}
+
+int Fake_getPin(uint8_t pin)
+{
+    return (pin < FAKE_PIN_COUNT) ? Fake_pinLevel[pin] : LOW;
+}
+
+void Fake_setLog(bool enabled)
+{
+    Fake_log = enabled;
+}
+
+unsigned long millis(void)
+{
+    return (unsigned long)(uint32_t)(Fake_time / 1000);
+}
+
+unsigned long micros(void)
+{
+    return (unsigned long)(uint32_t)Fake_time;
+}
+
+void delay(uint32_t ms)
+{
+    Fake_advance(ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    Fake_advance(us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    if (pin < FAKE_PIN_COUNT)
+        Fake_pinLevel[pin] = value;
+}
+
+int digitalRead(uint8_t pin)
+{
+    return Fake_getPin(pin);
+}
+
+void attachInterrupt(uint8_t pin, void (* isr)(void), int mode)
+{
+    if (pin >= FAKE_PIN_COUNT)
+        return;
+
+    Fake_isr[pin] = isr;
+    Fake_isrMode[pin] = mode;
+}
+
+void detachInterrupt(uint8_t pin)
+{
+    if (pin < FAKE_PIN_COUNT)
+        Fake_isr[pin] = nullptr;
+}
+
+uint32_t esp_random(void)
+{
+    /* xorshift32, deterministic across runs */
+    Fake_randomState ^= Fake_randomState << 13;
+    Fake_randomState ^= Fake_randomState >> 17;
+    Fake_randomState ^= Fake_randomState << 5;
+    return Fake_randomState;
+}
+
+uint32_t EspClass::getCycleCount(void)
+{
+    return (uint32_t)(Fake_time * getCpuFreqMHz());
+}
+
+void HardwareSerial::begin(unsigned long baud)
+{
+    (void)baud;
+}
+
+int HardwareSerial::available(void)
+{
+    return (int)rx.size();
+}
+
+int HardwareSerial::read(void)
+{
+    if (rx.empty())
+        return -1;
+
+    uint8_t value = rx.front();
+    rx.pop_front();
+    return value;
+}
+
+size_t HardwareSerial::write(uint8_t value)
+{
+    if (txHandler)
+        txHandler(value);
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t * buffer, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+        write(buffer[i]);
+    return length;
+}
+
+void HardwareSerial::onReceive(void (* callback)(void), bool onlyOnTimeout)
+{
+    (void)onlyOnTimeout;
+    receiveCallback = callback;
+}
+
+void HardwareSerial::inject(const uint8_t * buffer, size_t length)
+{
+    rx.insert(rx.end(), buffer, buffer + length);
+    if (receiveCallback != nullptr)
+        receiveCallback();
+}
+
+size_t HardwareSerial::print(const char * text)
+{
+    return (size_t)printf("%s", text);
+}
+
+size_t HardwareSerial::print(int value)
+{
+    return (size_t)printf("%d", value);
+}
+
+size_t HardwareSerial::print(unsigned int value)
+{
+    return (size_t)printf("%u", value);
+}
+
+size_t HardwareSerial::print(long value)
+{
+    return (size_t)printf("%ld", value);
+}
+
+size_t HardwareSerial::print(unsigned long value)
+{
+    return (size_t)printf("%lu", value);
+}
+
+size_t HardwareSerial::println(const char * text)
+{
+    return (size_t)printf("%s\n", text);
+}
+
+size_t HardwareSerial::println(int value)
+{
+    return (size_t)printf("%d\n", value);
+}
+
+size_t HardwareSerial::println(unsigned int value)
+{
+    return (size_t)printf("%u\n", value);
+}
+
+size_t HardwareSerial::println(long value)
+{
+    return (size_t)printf("%ld\n", value);
+}
+
+size_t HardwareSerial::println(unsigned long value)
+{
+    return (size_t)printf("%lu\n", value);
+}
+
+int HardwareSerial::printf(const char * format, ...)
+{
+    char text[512];
+    va_list args;
+
+    va_start(args, format);
+    int length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+
+    if (txHandler)
+    {
+        for (const char * c = text; *c != '\0'; c++)
+            txHandler((uint8_t)*c);
+    }
+    else if (Fake_log)
+        fprintf(stdout, "[%9.3f] %s", Fake_time / 1000.0, text);
+
+    return length;
+}
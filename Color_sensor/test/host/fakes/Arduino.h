@@ -0,0 +1,158 @@
+#ifndef FAKE_ARDUINO_H
+#define FAKE_ARDUINO_H
+
+/* Host stand-in of the Arduino-ESP32 core: the subset used by the sketch
+ * sources and the vendored drivers, on a simulated clock (see FakeArduino.h)
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include <deque>
+#include <functional>
+#include <string>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define IRAM_ATTR
+
+#define _min(a, b) ((a) < (b) ? (a) : (b))
+#define _max(a, b) ((a) > (b) ? (a) : (b))
+
+#define digitalPinToInterrupt(pin) (pin)
+
+/* Flash strings are plain strings on the host */
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(text) (text)
+#define FPSTR(text) (reinterpret_cast<const __FlashStringHelper *>(text))
+#define F(text) FPSTR(text)
+#define strlen_P strlen
+#define strcpy_P strcpy
+#define strcat_P strcat
+#define strcmp_P strcmp
+#define memcpy_P memcpy
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+
+class __FlashStringHelper;
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+/* Time zone and SNTP servers of the system clock (FakeSntp.cpp) */
+void configTime(long gmtOffset_sec, int daylightOffset_sec, const char * server1,
+        const char * server2 = nullptr, const char * server3 = nullptr);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (* isr)(void), int mode);
+void detachInterrupt(uint8_t pin);
+
+uint32_t esp_random(void);
+
+/* Arduino String, enough for what the sketch sources and FirebaseJson use */
+class String
+{
+public:
+    String(const char * text = "") : value((text != nullptr) ? text : "") {}
+    String(const std::string & text) : value(text) {}
+    explicit String(char c) : value(1, c) {}
+    explicit String(int number) : value(std::to_string(number)) {}
+    explicit String(unsigned int number) : value(std::to_string(number)) {}
+    explicit String(long number) : value(std::to_string(number)) {}
+    explicit String(unsigned long number) : value(std::to_string(number)) {}
+    const char * c_str(void) const { return value.c_str(); }
+    unsigned int length(void) const { return (unsigned int)value.size(); }
+    bool reserve(unsigned int size) { value.reserve(size); return true; }
+    void remove(unsigned int index, unsigned int count = (unsigned int)-1) { value.erase(index, count); }
+    String & operator+=(const String & text) { value += text.value; return *this; }
+    bool operator==(const char * text) const { return value == text; }
+    char operator[](unsigned int index) const { return value[index]; }
+
+private:
+    std::string value;
+};
+
+/* Result of a String concatenation */
+class StringSumHelper : public String
+{
+public:
+    StringSumHelper(const String & text) : String(text) {}
+};
+
+inline StringSumHelper operator+(const String & left, const String & right)
+{
+    String sum = left;
+    sum += right;
+    return StringSumHelper(sum);
+}
+
+/* UART: what the sketch writes goes to a handler (device model or log),
+ * what the device model injects is read back and raises onReceive()
+ */
+class HardwareSerial
+{
+public:
+    void begin(unsigned long baud);
+    void end(void) {}
+    int available(void);
+    int read(void);
+    size_t write(uint8_t value);
+    size_t write(const uint8_t * buffer, size_t length);
+    void flush(void) {}
+    void onReceive(void (* callback)(void), bool onlyOnTimeout = false);
+
+    size_t print(const char * text);
+    size_t print(int value);
+    size_t print(unsigned int value);
+    size_t print(long value);
+    size_t print(unsigned long value);
+    size_t println(const char * text = "");
+    size_t println(int value);
+    size_t println(unsigned int value);
+    size_t println(long value);
+    size_t println(unsigned long value);
+    int printf(const char * format, ...) __attribute__((format(printf, 2, 3)));
+
+    /* Host side */
+    std::function<void(uint8_t)> txHandler;
+    void inject(const uint8_t * buffer, size_t length);
+
+private:
+    std::deque<uint8_t> rx;
+    void (* receiveCallback)(void) = nullptr;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial2;
+
+class EspClass
+{
+public:
+    uint32_t getCycleCount(void);
+    uint32_t getCpuFreqMHz(void) { return 240; }
+};
+
+extern EspClass ESP;
+
+#endif /* FAKE_ARDUINO_H */
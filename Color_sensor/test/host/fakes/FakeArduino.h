@@ -0,0 +1,33 @@
+#ifndef FAKE_ARDUINO_CONTROL_H
+#define FAKE_ARDUINO_CONTROL_H
+
+#include <Arduino.h>
+
+/* Host side control of the fake Arduino core: simulated clock and GPIO
+ *
+ */
+
+/* Clock back to 0, pins released, interrupts detached, UARTs emptied */
+void Fake_reset(void);
+
+/* Simulated time in microseconds since reset */
+uint64_t Fake_micros(void);
+
+/* Advance the clock, device models follow through the tick hook */
+void Fake_advance(uint32_t us);
+
+/* Called with the new time whenever the clock advances, including
+ * inside delay() of a driver, so device models stay in step
+ */
+void Fake_setTickHook(std::function<void(uint64_t)> hook);
+
+/* Drive an input pin from a device model,
+ * the attached interrupt runs on a matching edge
+ */
+void Fake_setPin(uint8_t pin, int level);
+int Fake_getPin(uint8_t pin);
+
+/* Print Serial output on stdout (default: only if HOST_TEST_VERBOSE is set) */
+void Fake_setLog(bool enabled);
+
+#endif /* FAKE_ARDUINO_CONTROL_H */
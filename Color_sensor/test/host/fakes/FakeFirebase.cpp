@@ -0,0 +1,208 @@
+#include "Lib/Firebase_ESP32_Client/src/FirebaseESP32.h"
+#include "FakeFirebase.h"
+
+FirebaseESP32 Firebase;
+
+static std::map<std::string, std::string> FakeFirebase_data;
+static std::vector<t_FakeFirebaseRequest> FakeFirebase_log;
+static bool FakeFirebase_ready = true;
+static uint32_t FakeFirebase_failures = 0;
+static bool FakeFirebase_failApplied = false;
+static std::string FakeFirebase_error;
+
+void FakeFirebase_reset(void)
+{
+    FakeFirebase_data.clear();
+    FakeFirebase_log.clear();
+    FakeFirebase_ready = true;
+    FakeFirebase_failures = 0;
+}
+
+void FakeFirebase_setReady(bool ready)
+{
+    FakeFirebase_ready = ready;
+}
+
+void FakeFirebase_failNext(uint32_t requests, bool applied)
+{
+    FakeFirebase_failures = requests;
+    FakeFirebase_failApplied = applied;
+}
+
+const std::vector<t_FakeFirebaseRequest> & FakeFirebase_requests(void)
+{
+    return FakeFirebase_log;
+}
+
+const std::map<std::string, std::string> & FakeFirebase_database(void)
+{
+    return FakeFirebase_data;
+}
+
+std::map<std::string, std::string> FakeFirebase_children(const std::string & path)
+{
+    std::map<std::string, std::string> children;
+    std::string prefix = path + "/";
+
+    for (const auto & entry : FakeFirebase_data)
+    {
+        if (entry.first.compare(0, prefix.size(), prefix) == 0)
+            children[entry.first.substr(prefix.size())] = entry.second;
+    }
+
+    return children;
+}
+
+static size_t FakeFirebase_skipSpace(const std::string & json, size_t i)
+{
+    while ((i < json.size()) && isspace((unsigned char)json[i]))
+        i++;
+    return i;
+}
+
+/* End (exclusive) of the JSON value starting at i */
+static size_t FakeFirebase_valueEnd(const std::string & json, size_t i)
+{
+    int depth = 0;
+    bool inString = false;
+
+    for (; i < json.size(); i++)
+    {
+        char c = json[i];
+
+        if (inString)
+        {
+            if (c == '\\')
+                i++;
+            else if (c == '"')
+                inString = false;
+            continue;
+        }
+
+        if (c == '"')
+            inString = true;
+        else if ((c == '{') || (c == '['))
+            depth++;
+        else if ((c == '}') || (c == ']'))
+        {
+            if (depth == 0)
+                return i;
+            depth--;
+        }
+        else if ((c == ',') && (depth == 0))
+            return i;
+    }
+
+    return i;
+}
+
+std::map<std::string, std::string> FakeFirebase_parseObject(const std::string & json)
+{
+    std::map<std::string, std::string> members;
+    size_t i = FakeFirebase_skipSpace(json, 0);
+
+    if ((i >= json.size()) || (json[i] != '{'))
+        return members;
+    i++;
+
+    while (true)
+    {
+        i = FakeFirebase_skipSpace(json, i);
+        if ((i >= json.size()) || (json[i] != '"'))
+            break;
+
+        size_t keyEnd = json.find('"', i + 1);
+        std::string key = json.substr(i + 1, keyEnd - i - 1);
+        i = FakeFirebase_skipSpace(json, keyEnd + 1);
+        if (json[i] != ':')
+            break;
+
+        size_t start = FakeFirebase_skipSpace(json, i + 1);
+        size_t end = FakeFirebase_valueEnd(json, start);
+        members[key] = json.substr(start, end - start);
+
+        i = FakeFirebase_skipSpace(json, end);
+        if ((i >= json.size()) || (json[i] != ','))
+            break;
+        i++;
+    }
+
+    return members;
+}
+
+/* Write a value at a path, server values resolved */
+static void FakeFirebase_set(const std::string & path, const std::string & value)
+{
+    std::map<std::string, std::string> members = FakeFirebase_parseObject(value);
+    auto serverValue = members.find(".sv");
+
+    if (serverValue != members.end())
+    {
+        std::map<std::string, std::string> operation = FakeFirebase_parseObject(serverValue->second);
+        auto increment = operation.find("increment");
+
+        if (increment != operation.end())
+        {
+            long long current = FakeFirebase_data.count(path) ? atoll(FakeFirebase_data[path].c_str()) : 0;
+            FakeFirebase_data[path] = std::to_string(current + atoll(increment->second.c_str()));
+        }
+        else
+            FakeFirebase_data[path] = std::to_string(millis());
+        return;
+    }
+
+    /* A new value replaces the whole subtree */
+    std::string prefix = path + "/";
+    for (auto entry = FakeFirebase_data.begin(); entry != FakeFirebase_data.end();)
+    {
+        if ((entry->first == path) || (entry->first.compare(0, prefix.size(), prefix) == 0))
+            entry = FakeFirebase_data.erase(entry);
+        else
+            entry++;
+    }
+
+    if (members.empty())
+        FakeFirebase_data[path] = value;
+    else
+    {
+        for (const auto & member : members)
+            FakeFirebase_set(prefix + member.first, member.second);
+    }
+}
+
+bool FakeRTDB::updateNodeSilentRaw(FirebaseData * fbdo, const char * path, const char * json)
+{
+    (void)fbdo;
+
+    bool fail = (FakeFirebase_failures > 0);
+    bool apply = !fail || FakeFirebase_failApplied;
+    if (fail)
+        FakeFirebase_failures--;
+
+    /* Update: each member replaces its child, other children stay */
+    if (apply)
+    {
+        for (const auto & member : FakeFirebase_parseObject(json))
+            FakeFirebase_set(std::string(path) + "/" + member.first, member.second);
+    }
+
+    FakeFirebase_log.push_back({path, json, apply, !fail});
+    FakeFirebase_error = fail ? (apply ? "response read timed out" : "connection refused") : "";
+    return !fail;
+}
+
+String FirebaseData::errorReason(void)
+{
+    return String(FakeFirebase_error);
+}
+
+void FirebaseESP32::begin(FirebaseConfig * config, FirebaseAuth * auth)
+{
+    (void)config;
+    (void)auth;
+}
+
+bool FirebaseESP32::ready(void)
+{
+    return FakeFirebase_ready;
+}
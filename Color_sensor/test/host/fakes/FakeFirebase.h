@@ -0,0 +1,46 @@
+#ifndef FAKE_FIREBASE_H
+#define FAKE_FIREBASE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+/* Host side control of the fake Firebase client
+ *
+ */
+
+/* Request received by the fake server */
+typedef struct
+{
+    std::string path;
+    std::string json;
+    bool applied;  /* Written to the database */
+    bool answered; /* Reported as success to the client */
+} t_FakeFirebaseRequest;
+
+/* Back to an empty database, online, authenticated */
+void FakeFirebase_reset(void);
+
+/* Authentication state (Firebase.ready()) */
+void FakeFirebase_setReady(bool ready);
+
+/* Next requests fail: not applied (connection refused) or applied
+ * but the answer lost (timeout after the server wrote, ambiguous)
+ */
+void FakeFirebase_failNext(uint32_t requests, bool applied);
+
+/* All requests since reset */
+const std::vector<t_FakeFirebaseRequest> & FakeFirebase_requests(void);
+
+/* Database content, one entry per leaf or object value (path of parent + "/" + key),
+ * updates replace children like the RTDB, {".sv":{"increment":n}} adds to a number
+ */
+const std::map<std::string, std::string> & FakeFirebase_database(void);
+
+/* Children of a node: key -> raw JSON value */
+std::map<std::string, std::string> FakeFirebase_children(const std::string & path);
+
+/* Split a JSON object into its members (key -> raw JSON value) */
+std::map<std::string, std::string> FakeFirebase_parseObject(const std::string & json);
+
+#endif /* FAKE_FIREBASE_H */
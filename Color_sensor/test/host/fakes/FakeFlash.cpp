@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Journal.h"
+#include "FakeFlash.h"
+
+static std::string FakeFlash_root;
+static bool FakeFlash_tear = false;
+static size_t FakeFlash_tearBytes = 0;
+
+void FakeFlash_format(void)
+{
+    char root[] = "/tmp/color_sensor_flash_XXXXXX";
+    FakeFlash_root = (mkdtemp(root) != nullptr) ? root : "/tmp";
+    FakeFlash_tear = false;
+}
+
+void FakeFlash_erase(void)
+{
+    if (FakeFlash_root.empty())
+        return;
+
+    std::string command = "rm -rf '" + FakeFlash_root + "'";
+    if (system(command.c_str()) != 0)
+        fprintf(stderr, "FakeFlash: cannot remove %s\n", FakeFlash_root.c_str());
+    FakeFlash_root.clear();
+}
+
+const char * FakeFlash_path(const char * path)
+{
+    static std::string full;
+    full = FakeFlash_root + path;
+    return full.c_str();
+}
+
+void FakeFlash_tearNextWrite(size_t bytes)
+{
+    FakeFlash_tear = true;
+    FakeFlash_tearBytes = bytes;
+}
+
+/* Parent directories are created on write, as MB_FS does */
+static void FakeFlash_createDirs(const char * path)
+{
+    std::string full = FakeFlash_path(path);
+    for (size_t i = FakeFlash_root.size() + 1; i < full.size(); i++)
+    {
+        if (full[i] == '/')
+            (void)mkdir(full.substr(0, i).c_str(), 0700);
+    }
+}
+
+static bool FakeFlash_exists(const char * path)
+{
+    return (access(FakeFlash_path(path), F_OK) == 0);
+}
+
+static int32_t FakeFlash_size(const char * path)
+{
+    struct stat info;
+    if (stat(FakeFlash_path(path), &info) != 0)
+        return -1;
+    return (int32_t)info.st_size;
+}
+
+static bool FakeFlash_read(const char * path, uint32_t offset, uint8_t * buffer, size_t length)
+{
+    FILE * file = fopen(FakeFlash_path(path), "rb");
+    if (file == nullptr)
+        return false;
+
+    bool ok = (fseek(file, offset, SEEK_SET) == 0) && (fread(buffer, 1, length, file) == length);
+    fclose(file);
+    return ok;
+}
+
+static bool FakeFlash_store(const char * path, const uint8_t * buffer, size_t length, const char * mode)
+{
+    FakeFlash_createDirs(path);
+
+    bool tear = FakeFlash_tear;
+    FakeFlash_tear = false;
+
+    if (tear && (FakeFlash_tearBytes == 0))
+        return false;
+
+    FILE * file = fopen(FakeFlash_path(path), mode);
+    if (file == nullptr)
+        return false;
+
+    size_t stored = tear ? ((FakeFlash_tearBytes < length) ? FakeFlash_tearBytes : length) : length;
+    bool ok = (fwrite(buffer, 1, stored, file) == stored);
+    fclose(file);
+    return ok && !tear;
+}
+
+static bool FakeFlash_append(const char * path, const uint8_t * buffer, size_t length)
+{
+    return FakeFlash_store(path, buffer, length, "ab");
+}
+
+static bool FakeFlash_write(const char * path, const uint8_t * buffer, size_t length)
+{
+    /* Remove, then create: not atomic */
+    (void)remove(FakeFlash_path(path));
+    return FakeFlash_store(path, buffer, length, "wb");
+}
+
+static bool FakeFlash_remove(const char * path)
+{
+    return (remove(FakeFlash_path(path)) == 0);
+}
+
+const t_JournalStorage Journal_flashStorage = {
+    FakeFlash_exists,
+    FakeFlash_size,
+    FakeFlash_read,
+    FakeFlash_append,
+    FakeFlash_write,
+    FakeFlash_remove
+};
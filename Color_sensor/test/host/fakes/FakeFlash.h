@@ -0,0 +1,27 @@
+#ifndef FAKE_FLASH_H
+#define FAKE_FLASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Host stand-in of JournalFlash.cpp: Journal_flashStorage on files of a
+ * directory. Whole-file writes remove then create the file, like MB_FS
+ * in mb_fs_open_mode_write, so a power loss in between is reproducible
+ */
+
+/* Use a fresh temporary directory as flash (removed by FakeFlash_erase()) */
+void FakeFlash_format(void);
+
+/* Remove all files of the flash directory and the directory */
+void FakeFlash_erase(void);
+
+/* Host path of a flash file, to inspect or damage it in a test */
+const char * FakeFlash_path(const char * path);
+
+/* Power loss during the next write or append: only the first bytes
+ * reach the file (0: the file is removed and not created again),
+ * the call fails
+ */
+void FakeFlash_tearNextWrite(size_t bytes);
+
+#endif /* FAKE_FLASH_H */
@@ -0,0 +1,27 @@
+#ifndef FAKE_I2C_H
+#define FAKE_I2C_H
+
+#include <Arduino.h>
+
+/* Device model answering I2C transfers at one address
+ *
+ */
+class FakeI2CTarget
+{
+public:
+    virtual ~FakeI2CTarget() {}
+
+    /* Master writes bytes (register pointer, values) */
+    virtual bool write(const uint8_t * buffer, size_t length) = 0;
+
+    /* Master reads bytes following the last write */
+    virtual bool read(uint8_t * buffer, size_t length) = 0;
+};
+
+/* Connect a device model to the bus (nullptr disconnects) */
+void FakeI2C_attach(uint8_t address, FakeI2CTarget * target);
+
+/* Bus transactions (write, read or write-then-read) addressed to a device since it was attached */
+uint32_t FakeI2C_transactions(uint8_t address);
+
+#endif /* FAKE_I2C_H */
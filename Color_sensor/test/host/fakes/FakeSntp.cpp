@@ -0,0 +1,68 @@
+#include <sys/time.h>
+#include <time.h>
+
+#include "FakeArduino.h"
+#include "FakeSntp.h"
+#include "esp_sntp.h"
+
+/* System clock: wall-clock microseconds at a simulated time, then running with it */
+static uint64_t FakeSntp_epochUs = 0;
+static uint64_t FakeSntp_setAtUs = 0;
+static bool FakeSntp_completed = false;
+
+static uint64_t FakeSntp_nowUs(void)
+{
+    return FakeSntp_epochUs + (Fake_micros() - FakeSntp_setAtUs);
+}
+
+void FakeSntp_reset(void)
+{
+    FakeSntp_epochUs = 0;
+    FakeSntp_setAtUs = Fake_micros();
+    FakeSntp_completed = false;
+}
+
+void FakeSntp_update(uint64_t epochMs)
+{
+    FakeSntp_epochUs = epochMs * 1000;
+    FakeSntp_setAtUs = Fake_micros();
+    FakeSntp_completed = true;
+}
+
+sntp_sync_status_t sntp_get_sync_status(void)
+{
+    sntp_sync_status_t status = FakeSntp_completed ? SNTP_SYNC_STATUS_COMPLETED : SNTP_SYNC_STATUS_RESET;
+    FakeSntp_completed = false;
+    return status;
+}
+
+/* Time zone as the ESP32 core sets it, the SNTP server is not contacted */
+void configTime(long gmtOffset_sec, int daylightOffset_sec, const char * server1, const char * server2, const char * server3)
+{
+    (void)server1;
+    (void)server2;
+    (void)server3;
+
+    char zone[24];
+    snprintf(zone, sizeof(zone), "UTC%+ld", -(gmtOffset_sec + daylightOffset_sec) / 3600);
+    setenv("TZ", zone, 1);
+    tzset();
+}
+
+extern "C" int __wrap_gettimeofday(struct timeval * now, void * zone)
+{
+    (void)zone;
+
+    uint64_t us = FakeSntp_nowUs();
+    now->tv_sec = (time_t)(us / 1000000);
+    now->tv_usec = (suseconds_t)(us % 1000000);
+    return 0;
+}
+
+extern "C" time_t __wrap_time(time_t * seconds)
+{
+    time_t now = (time_t)(FakeSntp_nowUs() / 1000000);
+    if (seconds != nullptr)
+        *seconds = now;
+    return now;
+}
@@ -0,0 +1,17 @@
+#ifndef FAKE_SNTP_H
+#define FAKE_SNTP_H
+
+#include <stdint.h>
+
+/* Host stand-in of SNTP and the system clock for the real TimeService.cpp:
+ * gettimeofday() and time() run on the simulated clock once the binary
+ * is linked with -Wl,--wrap=gettimeofday -Wl,--wrap=time
+ */
+
+/* System clock back to 1970, no update reported */
+void FakeSntp_reset(void);
+
+/* SNTP update: system clock set to a wall-clock time now, reported once */
+void FakeSntp_update(uint64_t epochMs);
+
+#endif /* FAKE_SNTP_H */
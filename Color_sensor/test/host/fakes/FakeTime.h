@@ -0,0 +1,9 @@
+#ifndef FAKE_TIME_H
+#define FAKE_TIME_H
+
+#include <stdint.h>
+
+/* Synchronize the fake TimeService: wall-clock ms at millis() == 0 (0: not synced) */
+void FakeTime_set(uint64_t epochMsAtBoot);
+
+#endif /* FAKE_TIME_H */
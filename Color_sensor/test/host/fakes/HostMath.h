@@ -0,0 +1,10 @@
+#ifndef FAKE_HOST_MATH_H
+#define FAKE_HOST_MATH_H
+
+/* Forced include for Adafruit_TCS34725.cpp: its powf() replacement
+ * would clash with the C library declaration on the host
+ */
+#include <math.h>
+#define powf Adafruit_TCS34725_powf
+
+#endif /* FAKE_HOST_MATH_H */
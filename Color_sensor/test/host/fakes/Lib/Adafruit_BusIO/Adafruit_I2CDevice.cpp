@@ -0,0 +1,103 @@
+/* Fake of the vendored Adafruit_I2CDevice: same class (header from
+ * src/Lib/Adafruit_BusIO), transfers served by FakeI2CTarget models
+ */
+#include <Adafruit_I2CDevice.h>
+
+#include "FakeI2C.h"
+
+TwoWire Wire;
+
+static FakeI2CTarget * FakeI2C_targets[128];
+static uint32_t FakeI2C_count[128];
+
+void FakeI2C_attach(uint8_t address, FakeI2CTarget * target)
+{
+    FakeI2C_targets[address & 0x7F] = target;
+    FakeI2C_count[address & 0x7F] = 0;
+}
+
+uint32_t FakeI2C_transactions(uint8_t address)
+{
+    return FakeI2C_count[address & 0x7F];
+}
+
+static FakeI2CTarget * FakeI2C_target(uint8_t address)
+{
+    FakeI2CTarget * target = FakeI2C_targets[address & 0x7F];
+    if (target != nullptr)
+        FakeI2C_count[address & 0x7F]++;
+    return target;
+}
+
+Adafruit_I2CDevice::Adafruit_I2CDevice(uint8_t addr, TwoWire * theWire)
+{
+    _addr = addr;
+    _wire = theWire;
+    _begun = false;
+    _maxBufferSize = 128;
+}
+
+uint8_t Adafruit_I2CDevice::address(void)
+{
+    return _addr;
+}
+
+bool Adafruit_I2CDevice::begin(bool addr_detect)
+{
+    _begun = true;
+    return !addr_detect || detected();
+}
+
+void Adafruit_I2CDevice::end(void)
+{
+    _begun = false;
+}
+
+bool Adafruit_I2CDevice::detected(void)
+{
+    return (FakeI2C_targets[_addr & 0x7F] != nullptr);
+}
+
+bool Adafruit_I2CDevice::read(uint8_t * buffer, size_t len, bool stop)
+{
+    return _read(buffer, len, stop);
+}
+
+bool Adafruit_I2CDevice::_read(uint8_t * buffer, size_t len, bool stop)
+{
+    (void)stop;
+    FakeI2CTarget * target = FakeI2C_target(_addr);
+    return (target != nullptr) && target->read(buffer, len);
+}
+
+bool Adafruit_I2CDevice::write(const uint8_t * buffer, size_t len, bool stop, const uint8_t * prefix_buffer, size_t prefix_len)
+{
+    (void)stop;
+    FakeI2CTarget * target = FakeI2C_target(_addr);
+    if (target == nullptr)
+        return false;
+
+    uint8_t data[256];
+    if ((prefix_len + len) > sizeof(data))
+        return false;
+
+    if (prefix_len > 0)
+        memcpy(data, prefix_buffer, prefix_len);
+    memcpy(&data[prefix_len], buffer, len);
+
+    return target->write(data, prefix_len + len);
+}
+
+bool Adafruit_I2CDevice::write_then_read(const uint8_t * write_buffer, size_t write_len, uint8_t * read_buffer, size_t read_len, bool stop)
+{
+    (void)stop;
+    FakeI2CTarget * target = FakeI2C_target(_addr);
+
+    return (target != nullptr) && target->write(write_buffer, write_len) && target->read(read_buffer, read_len);
+}
+
+bool Adafruit_I2CDevice::setSpeed(uint32_t desiredclk)
+{
+    (void)desiredclk;
+    return true;
+}
@@ -0,0 +1,58 @@
+#ifndef FAKE_FIREBASE_ESP32_H
+#define FAKE_FIREBASE_ESP32_H
+
+/* Host stand-in of the Firebase client: the calls FirebaseDb.cpp makes,
+ * served by an in-memory database (see FakeFirebase.h)
+ */
+#include <Arduino.h>
+
+struct TokenInfo
+{
+    int status;
+};
+
+class FirebaseData
+{
+public:
+    void setResponseSize(int size) { (void)size; }
+    String errorReason(void);
+};
+
+struct FirebaseAuth
+{
+    struct
+    {
+        String email;
+        String password;
+    } user;
+};
+
+struct FirebaseConfig
+{
+    String api_key;
+    String database_url;
+    void (* token_status_callback)(TokenInfo) = nullptr;
+    int max_token_generation_retry = 0;
+};
+
+class FakeRTDB
+{
+public:
+    bool updateNodeSilentRaw(FirebaseData * fbdo, const char * path, const char * json);
+};
+
+class FirebaseESP32
+{
+public:
+    void begin(FirebaseConfig * config, FirebaseAuth * auth);
+    void reconnectWiFi(bool reconnect) { (void)reconnect; }
+    bool ready(void);
+    bool isTokenExpired(void) { return false; }
+    void refreshToken(FirebaseConfig * config) { (void)config; }
+
+    FakeRTDB RTDB;
+};
+
+extern FirebaseESP32 Firebase;
+
+#endif /* FAKE_FIREBASE_ESP32_H */
@@ -0,0 +1,6 @@
+#ifndef FAKE_RTDB_HELPER_H
+#define FAKE_RTDB_HELPER_H
+
+/* Payload printing helpers, not used on the host */
+
+#endif /* FAKE_RTDB_HELPER_H */
@@ -0,0 +1,11 @@
+#ifndef FAKE_TOKEN_HELPER_H
+#define FAKE_TOKEN_HELPER_H
+
+#include "../FirebaseESP32.h"
+
+static inline void tokenStatusCallback(TokenInfo info)
+{
+    (void)info;
+}
+
+#endif /* FAKE_TOKEN_HELPER_H */
@@ -0,0 +1,144 @@
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Preferences.h"
+
+typedef std::map<std::string, std::vector<uint8_t>> t_FakeNvsSpace;
+
+static std::map<std::string, t_FakeNvsSpace> FakeNvs_spaces;
+
+bool Preferences::begin(const char * name, bool readOnly)
+{
+    snprintf(space, sizeof(space), "%s", name);
+    this->readOnly = readOnly;
+
+    /* Read-only open fails on a namespace never written, as on NVS */
+    if (readOnly && (FakeNvs_spaces.find(space) == FakeNvs_spaces.end()))
+        return false;
+
+    opened = true;
+    return true;
+}
+
+void Preferences::end(void)
+{
+    opened = false;
+}
+
+size_t Preferences::getBytes(const char * key, void * buffer, size_t length)
+{
+    if (!opened)
+        return 0;
+
+    t_FakeNvsSpace & entries = FakeNvs_spaces[space];
+    auto entry = entries.find(key);
+    if ((entry == entries.end()) || (entry->second.size() > length))
+        return 0;
+
+    memcpy(buffer, entry->second.data(), entry->second.size());
+    return entry->second.size();
+}
+
+size_t Preferences::putBytes(const char * key, const void * buffer, size_t length)
+{
+    if (!opened || readOnly)
+        return 0;
+
+    const uint8_t * bytes = (const uint8_t *)buffer;
+    FakeNvs_spaces[space][key] = std::vector<uint8_t>(bytes, bytes + length);
+    return length;
+}
+
+uint32_t Preferences::getULong(const char * key, uint32_t defaultValue)
+{
+    uint32_t value;
+    return (getBytes(key, &value, sizeof(value)) == sizeof(value)) ? value : defaultValue;
+}
+
+size_t Preferences::putULong(const char * key, uint32_t value)
+{
+    return putBytes(key, &value, sizeof(value));
+}
+
+bool Preferences::remove(const char * key)
+{
+    return opened && !readOnly && (FakeNvs_spaces[space].erase(key) > 0);
+}
+
+bool Preferences::clear(void)
+{
+    if (!opened || readOnly)
+        return false;
+
+    FakeNvs_spaces[space].clear();
+    return true;
+}
+
+void FakeNvs_erase(void)
+{
+    FakeNvs_spaces.clear();
+}
+
+/* File layout: per entry, namespace, key (NUL terminated) then 32-bit length and value */
+bool FakeNvs_save(const char * path)
+{
+    FILE * file = fopen(path, "wb");
+    if (file == nullptr)
+        return false;
+
+    for (const auto & space : FakeNvs_spaces)
+    {
+        for (const auto & entry : space.second)
+        {
+            uint32_t length = (uint32_t)entry.second.size();
+            fwrite(space.first.c_str(), 1, space.first.size() + 1, file);
+            fwrite(entry.first.c_str(), 1, entry.first.size() + 1, file);
+            fwrite(&length, sizeof(length), 1, file);
+            fwrite(entry.second.data(), 1, length, file);
+        }
+    }
+
+    return (fclose(file) == 0);
+}
+
+static bool FakeNvs_readString(FILE * file, std::string * text)
+{
+    int c;
+    text->clear();
+
+    while ((c = fgetc(file)) != EOF)
+    {
+        if (c == '\0')
+            return true;
+        text->push_back((char)c);
+    }
+
+    return false;
+}
+
+bool FakeNvs_load(const char * path)
+{
+    FILE * file = fopen(path, "rb");
+    if (file == nullptr)
+        return false;
+
+    FakeNvs_spaces.clear();
+
+    std::string space, key;
+    while (FakeNvs_readString(file, &space) && FakeNvs_readString(file, &key))
+    {
+        uint32_t length;
+        if (fread(&length, sizeof(length), 1, file) != 1)
+            break;
+
+        std::vector<uint8_t> value(length);
+        if (fread(value.data(), 1, length, file) != length)
+            break;
+
+        FakeNvs_spaces[space][key] = value;
+    }
+
+    fclose(file);
+    return true;
+}
@@ -0,0 +1,35 @@
+#ifndef FAKE_PREFERENCES_H
+#define FAKE_PREFERENCES_H
+
+#include <Arduino.h>
+
+/* NVS namespace in process memory, kept across Preferences objects
+ * (see FakeNvs_xxx() to carry it over a simulated reboot)
+ */
+class Preferences
+{
+public:
+    bool begin(const char * name, bool readOnly = false);
+    void end(void);
+
+    size_t getBytes(const char * key, void * buffer, size_t length);
+    size_t putBytes(const char * key, const void * buffer, size_t length);
+    uint32_t getULong(const char * key, uint32_t defaultValue = 0);
+    size_t putULong(const char * key, uint32_t value);
+    bool remove(const char * key);
+    bool clear(void);
+
+private:
+    char space[16] = "";
+    bool opened = false;
+    bool readOnly = true;
+};
+
+/* Erase all namespaces */
+void FakeNvs_erase(void);
+
+/* Save to or load from a file, to model the same flash seen by several boots */
+bool FakeNvs_save(const char * path);
+bool FakeNvs_load(const char * path);
+
+#endif /* FAKE_PREFERENCES_H */
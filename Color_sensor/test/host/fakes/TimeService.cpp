@@ -0,0 +1,52 @@
+/* Host stand-in of TimeService.cpp: wall clock = epoch set by the test + millis() */
+#include <Arduino.h>
+#include <time.h>
+
+#include "TimeService.h"
+#include "FakeTime.h"
+
+static uint64_t FakeTime_epochAtBoot = 0;
+
+void FakeTime_set(uint64_t epochMsAtBoot)
+{
+    FakeTime_epochAtBoot = epochMsAtBoot;
+}
+
+void TimeService_init(void)
+{
+}
+
+void TimeService_task(void)
+{
+}
+
+bool TimeService_isSynced(void)
+{
+    return (FakeTime_epochAtBoot != 0);
+}
+
+uint64_t TimeService_nowMs(void)
+{
+    return TimeService_epochMsAt(millis());
+}
+
+uint64_t TimeService_epochMsAt(uint32_t timestamp)
+{
+    return (FakeTime_epochAtBoot != 0) ? (FakeTime_epochAtBoot + timestamp) : 0;
+}
+
+const char * TimeService_formatDate(uint32_t epoch)
+{
+    static char date[TIME_DATE_LENGTH];
+    time_t seconds = epoch;
+    struct tm local;
+
+    gmtime_r(&seconds, &local);
+    strftime(date, sizeof(date), "%d/%m/%Y %H:%M:%S", &local);
+    return date;
+}
+
+void TimeService_getSyncInfo(t_TimeSyncInfo * info)
+{
+    *info = {TimeService_isSynced(), 1, 0, 0, 0};
+}
@@ -0,0 +1,16 @@
+#ifndef FAKE_WIRE_H
+#define FAKE_WIRE_H
+
+#include <Arduino.h>
+
+/* I2C bus handle only, transfers are served by the fake Adafruit_I2CDevice */
+class TwoWire
+{
+public:
+    bool begin(void) { return true; }
+    void setClock(uint32_t frequency) { (void)frequency; }
+};
+
+extern TwoWire Wire;
+
+#endif /* FAKE_WIRE_H */
@@ -0,0 +1,16 @@
+#ifndef ESP_SNTP_H
+#define ESP_SNTP_H
+
+/* Host stand-in of the ESP-IDF SNTP client, driven by FakeSntp_update() */
+
+typedef enum
+{
+    SNTP_SYNC_STATUS_RESET,
+    SNTP_SYNC_STATUS_COMPLETED,
+    SNTP_SYNC_STATUS_IN_PROGRESS
+} sntp_sync_status_t;
+
+/* COMPLETED once after each update, then RESET again as in ESP-IDF */
+sntp_sync_status_t sntp_get_sync_status(void);
+
+#endif /* ESP_SNTP_H */
@@ -0,0 +1,12 @@
+#ifndef ESP_TIMER_H
+#define ESP_TIMER_H
+
+#include "FakeArduino.h"
+
+/* Host stand-in of the ESP-IDF high resolution timer, on the simulated clock */
+static inline int64_t esp_timer_get_time(void)
+{
+    return (int64_t)Fake_micros();
+}
+
+#endif /* ESP_TIMER_H */
@@ -0,0 +1,21 @@
+#ifndef FAKE_ROM_CRC_H
+#define FAKE_ROM_CRC_H
+
+#include <stdint.h>
+
+/* CRC-16/CCITT, reflected, as the ESP32 ROM crc16_le() (inverted in and out) */
+static inline uint16_t crc16_le(uint16_t crc, const uint8_t * buffer, uint32_t length)
+{
+    crc = ~crc;
+
+    for (uint32_t i = 0; i < length; i++)
+    {
+        crc ^= buffer[i];
+        for (uint8_t bit = 0; bit < 8; bit++)
+            crc = (crc & 1) ? ((crc >> 1) ^ 0x8408) : (crc >> 1);
+    }
+
+    return ~crc;
+}
+
+#endif /* FAKE_ROM_CRC_H */
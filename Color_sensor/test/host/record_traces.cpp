@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include "FakeArduino.h"
+#include "AppSim.h"
+#include "Calib.h"
+
+/* Records the traces replayed by test_replay from belt scenes of the simulator,
+ * with Application.cpp built with APP_TRACE_READINGS 1 (`make traces`).
+ * Traces of a real board are its Serial log with the same build, plus
+ * "trace object" lines added by hand
+ */
+
+static const t_SimLight TRACE_RED = BeltScene_colorLight(170, 51, 42, 60.0);
+static const t_SimLight TRACE_GREEN = BeltScene_colorLight(45, 160, 60, 70.0);
+static const t_SimLight TRACE_BLUE = BeltScene_colorLight(40, 70, 150, 50.0);
+static const t_SimLight TRACE_YELLOW = BeltScene_colorLight(200, 190, 60, 300.0); /* Saturates preview exposure */
+static const t_SimLight TRACE_NAVY = BeltScene_colorLight(40, 70, 150, 20.0);     /* Captured at high gain */
+
+typedef struct
+{
+    double length;
+    double height;
+    const t_SimLight * light;
+} t_TraceItem;
+
+/* Objects in belt order */
+static const t_TraceItem Trace_items[] = {
+    {40.0, 50.0, &TRACE_RED},
+    {25.0, 40.0, &TRACE_YELLOW},
+    {30.0, 80.0, &TRACE_GREEN},
+    {25.0, 40.0, &TRACE_NAVY},
+    {50.0, 30.0, &TRACE_BLUE},
+    {20.0, 60.0, &TRACE_RED},
+    {25.0, 45.0, &TRACE_YELLOW},
+    {40.0, 70.0, &TRACE_NAVY},
+    {25.0, 40.0, &TRACE_GREEN},
+    {35.0, 55.0, &TRACE_BLUE},
+};
+
+/* Gap between objects in millimetres, less than the sensor spacing:
+ * several objects are in flight whenever one is captured */
+#define TRACE_GAP 70.0
+
+static bool Trace_record(const char * path, t_AppCaptureMode mode)
+{
+    FILE * file = fopen(path, "w");
+    if (file == nullptr)
+        return false;
+
+    fprintf(file, "trace mode %s\n", (mode == APP_CAPTURE_FLYING) ? "flying" : "stop");
+
+    {
+        AppSim sim;
+
+        /* Keep the "trace" lines of the Serial output */
+        std::string line;
+        Serial.txHandler = [&](uint8_t c) {
+            line += (char)c;
+            if (c != '\n')
+                return;
+            if (line.compare(0, 6, "trace ") == 0)
+                fputs(line.c_str(), file);
+            line.clear();
+        };
+
+        App_setCaptureMode(mode);
+        sim.boot();
+        sim.runUntil([&] { return sim.motor; }, 5000);
+        sim.run(500);
+
+        double front = -20.0;
+        for (const t_TraceItem & item : Trace_items)
+        {
+            sim.scene.add(front, item.length, item.height, *item.light);
+            front -= item.length + TRACE_GAP;
+        }
+
+        /* Every object reaching the color sensor is an expected detection */
+        std::vector<bool> passed(sim.scene.objects.size(), false);
+        for (uint32_t ms = 0; ms < 30000; ms++)
+        {
+            sim.run(1);
+
+            for (size_t i = 0; i < sim.scene.objects.size(); i++)
+            {
+                const t_SimObject & object = sim.scene.objects[i];
+                if (passed[i] || (object.front < sim.scene.colorPosition))
+                    continue;
+
+                passed[i] = true;
+                fprintf(file, "trace object %u %ld %ld %ld\n", (uint32_t)millis(),
+                        lround(object.light.red * 255.0 / object.light.clear),
+                        lround(object.light.green * 255.0 / object.light.clear),
+                        lround(object.light.blue * 255.0 / object.light.clear));
+            }
+        }
+
+        Serial.txHandler = nullptr;
+    }
+
+    fclose(file);
+    return true;
+}
+
+/* One recording per process, so the application starts from reset:
+ * record_traces flying|stop <file>
+ */
+int main(int argc, char ** argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s flying|stop <file>\n", argv[0]);
+        return 2;
+    }
+
+    t_AppCaptureMode mode = (strcmp(argv[1], "flying") == 0) ? APP_CAPTURE_FLYING : APP_CAPTURE_STOP_AND_READ;
+    if (!Trace_record(argv[2], mode))
+    {
+        fprintf(stderr, "Cannot write %s\n", argv[2]);
+        return 1;
+    }
+
+    return 0;
+}
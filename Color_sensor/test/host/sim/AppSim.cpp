@@ -0,0 +1,120 @@
+#include "FakeArduino.h"
+#include "AppSim.h"
+
+#define SIM_COLOR_SENSOR_ADDRESS 0x29
+#define SIM_COLOR_SENSOR_INT_PIN 4
+
+/* Simulation step, and shortest sleep of the sketch's scheduler (one tick) */
+#define SIM_STEP_US 250
+#define SIM_TICK_MS 1
+
+AppSim * AppSim::active = nullptr;
+
+AppSim::Board::Board()
+{
+    Fake_reset();
+}
+
+AppSim::AppSim() : colorSensor(SIM_COLOR_SENSOR_INT_PIN), proximitySensor(Serial2)
+{
+    active = this;
+
+    colorSensor.setNoise(0.004);
+    colorSensor.setLight([this](uint64_t timeUs) { return scene.light(timeUs); });
+    proximitySensor.setDistance([this](uint64_t timeUs) { return scene.distance(timeUs); });
+    FakeI2C_attach(SIM_COLOR_SENSOR_ADDRESS, &colorSensor);
+
+    Fake_setTickHook([this](uint64_t nowUs) {
+        scene.advanceTo(nowUs);
+        colorSensor.update(nowUs);
+        proximitySensor.update(nowUs);
+    });
+}
+
+AppSim::~AppSim()
+{
+    Fake_setTickHook(nullptr);
+    FakeI2C_attach(SIM_COLOR_SENSOR_ADDRESS, nullptr);
+    active = nullptr;
+}
+
+void AppSim::detectionHandler(t_ObjectRecord * object)
+{
+    active->detections.push_back({(uint32_t)millis(), *object});
+}
+
+void AppSim::overheightHandler(void)
+{
+    active->overheights.push_back((uint32_t)millis());
+    active->setMotor(false);
+}
+
+void AppSim::motorHandler(bool state)
+{
+    active->setMotor(state && active->startupComplete);
+}
+
+void AppSim::wakeHandler(bool fromIsr)
+{
+    (void)fromIsr;
+    active->wake = true;
+}
+
+void AppSim::setMotor(bool state)
+{
+    if (motor == state)
+        return;
+
+    motor = state;
+    scene.motorOn = state;
+    motorEvents.push_back({(uint32_t)millis(), state, App_getOverheightCondition()});
+}
+
+void AppSim::boot(void)
+{
+    App_init();
+    App_setObjectDetectionCallback(detectionHandler);
+    App_setObjectOverheightCallback(overheightHandler);
+    App_setMotorCallback(motorHandler);
+    App_setWakeCallback(wakeHandler);
+}
+
+/* Same as appJob() of Color_sensor.ino */
+void AppSim::appJob(void)
+{
+    App_task();
+    setMotor(startupComplete && App_getMotorCondition());
+    appRuns++;
+
+    uint32_t delay = App_getNextRunDelay();
+    nextRun = millis() + ((delay > SIM_TICK_MS) ? delay : SIM_TICK_MS);
+}
+
+void AppSim::run(uint32_t ms)
+{
+    uint64_t end = Fake_micros() + ((uint64_t)ms * 1000);
+
+    while (Fake_micros() < end)
+    {
+        Fake_advance(SIM_STEP_US);
+
+        /* Scheduler: next deadline of the application or wake-up by a sensor event */
+        if (wake || ((int32_t)(millis() - nextRun) >= 0))
+        {
+            wake = false;
+            appJob();
+        }
+    }
+}
+
+bool AppSim::runUntil(std::function<bool(void)> done, uint32_t timeoutMs)
+{
+    for (uint32_t elapsed = 0; elapsed < timeoutMs; elapsed++)
+    {
+        if (done())
+            return true;
+        run(1);
+    }
+
+    return done();
+}
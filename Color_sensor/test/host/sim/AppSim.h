@@ -0,0 +1,79 @@
+#ifndef APPSIM_H
+#define APPSIM_H
+
+#include <vector>
+
+#include "Application.h"
+#include "BeltScene.h"
+#include "Tcs34725Sim.h"
+#include "Us100Sim.h"
+
+/* Detection handed over by the application */
+typedef struct
+{
+    uint32_t time; /* millis() of the callback */
+    t_ObjectRecord record;
+} t_SimDetection;
+
+/* Motor relay switching */
+typedef struct
+{
+    uint32_t time;
+    bool on;
+    bool overheight; /* App_getOverheightCondition() when switched */
+} t_SimMotorEvent;
+
+/* Board around Application.cpp: color sensor on the fake I2C bus
+ * (INT on GPIO 4), US-100 on Serial2, the motor relay and the
+ * sensor task job of Color_sensor.ino, all on the simulated clock
+ */
+class AppSim
+{
+    /* Fresh fake core, constructed before the device models attach to it */
+    struct Board
+    {
+        Board();
+    } board;
+
+public:
+    AppSim();
+    ~AppSim();
+
+    BeltScene scene;
+    Tcs34725Sim colorSensor;
+    Us100Sim proximitySensor;
+
+    /* Startup gate of the sketch (network up and time synchronized), holds the motor off */
+    bool startupComplete = true;
+
+    /* Observations */
+    std::vector<t_SimDetection> detections;
+    std::vector<uint32_t> overheights;
+    std::vector<t_SimMotorEvent> motorEvents;
+    bool motor = false;
+    uint32_t appRuns = 0;
+
+    /* setup() of the sketch, application part */
+    void boot(void);
+
+    /* Run the simulation for a time, or until a condition holds (false on timeout) */
+    void run(uint32_t ms);
+    bool runUntil(std::function<bool(void)> done, uint32_t timeoutMs);
+
+    /* Motor relay of the sketch */
+    void setMotor(bool state);
+
+private:
+    bool wake = false;
+    uint32_t nextRun = 0;
+
+    void appJob(void);
+
+    static AppSim * active;
+    static void detectionHandler(t_ObjectRecord * object);
+    static void overheightHandler(void);
+    static void motorHandler(bool state);
+    static void wakeHandler(bool fromIsr);
+};
+
+#endif /* APPSIM_H */
@@ -0,0 +1,103 @@
+#include "FakeArduino.h"
+#include "BeltScene.h"
+#include "Calib.h"
+
+BeltScene::BeltScene() : colorPosition(SENSOR_SPACING)
+{
+}
+
+void BeltScene::add(double front, double length, double height, t_SimLight light)
+{
+    objects.push_back({front, length, height, light});
+}
+
+void BeltScene::addOccluder(uint32_t start, uint32_t end, t_SimLight light)
+{
+    occluders.push_back({start, end, light});
+}
+
+double BeltScene::gaussian(void)
+{
+    double sum = 0.0;
+    for (uint8_t i = 0; i < 12; i++)
+    {
+        random = (random * 1664525u) + 1013904223u;
+        sum += (double)(random >> 8) / (double)(1u << 24);
+    }
+    return sum - 6.0;
+}
+
+void BeltScene::advanceTo(uint64_t nowUs)
+{
+    if (nowUs <= lastUs)
+        return;
+
+    if (motorOn)
+    {
+        double travel = speed * (double)(nowUs - lastUs) / 1e6;
+        for (t_SimObject & object : objects)
+            object.front += travel;
+    }
+
+    lastUs = nowUs;
+}
+
+int BeltScene::distance(uint64_t timeUs)
+{
+    advanceTo(timeUs);
+
+    double height = 0.0;
+    for (const t_SimObject & object : objects)
+    {
+        if ((object.front >= 0.0) && ((object.front - object.length) <= 0.0) && (object.height > height))
+            height = object.height;
+    }
+
+    return (int)lround(beltDistance - height + (distanceNoise * gaussian()));
+}
+
+t_SimLight BeltScene::light(uint64_t timeUs)
+{
+    advanceTo(timeUs);
+
+    uint32_t ms = (uint32_t)(timeUs / 1000);
+    for (const t_SimOccluder & occluder : occluders)
+    {
+        if ((ms >= occluder.start) && (ms < occluder.end))
+            return occluder.light;
+    }
+
+    /* Blend belt and objects by their share of the field of view */
+    double low = colorPosition - (colorSpot / 2), high = colorPosition + (colorSpot / 2);
+    double beltShare = 1.0;
+    t_SimLight light = {0.0, 0.0, 0.0, 0.0};
+
+    for (const t_SimObject & object : objects)
+    {
+        double overlap = fmin(high, object.front) - fmax(low, object.front - object.length);
+        if (overlap <= 0.0)
+            continue;
+
+        double share = overlap / colorSpot;
+        beltShare -= share;
+        light.clear += share * object.light.clear;
+        light.red += share * object.light.red;
+        light.green += share * object.light.green;
+        light.blue += share * object.light.blue;
+    }
+
+    if (beltShare > 0.0)
+    {
+        light.clear += beltShare * beltLight.clear;
+        light.red += beltShare * beltLight.red;
+        light.green += beltShare * beltLight.green;
+        light.blue += beltShare * beltLight.blue;
+    }
+
+    return light;
+}
+
+t_SimLight BeltScene_colorLight(uint8_t red, uint8_t green, uint8_t blue, double clear)
+{
+    return {clear, clear * red / 255.0, clear * green / 255.0, clear * blue / 255.0};
+}
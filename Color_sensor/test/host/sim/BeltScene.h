@@ -0,0 +1,73 @@
+#ifndef BELTSCENE_H
+#define BELTSCENE_H
+
+#include <vector>
+
+#include "Tcs34725Sim.h"
+
+/* Object lying on the belt, positions in millimetres along the belt
+ * (proximity sensor at 0, color sensor at SENSOR_SPACING, downstream positive)
+ */
+typedef struct
+{
+    double front;      /* Downstream edge */
+    double length;
+    double height;
+    t_SimLight light;  /* What the color sensor sees on the object */
+} t_SimObject;
+
+/* Something held in front of the color sensor only (e.g. a hand),
+ * from start to end in milliseconds of simulated time
+ */
+typedef struct
+{
+    uint32_t start;
+    uint32_t end;
+    t_SimLight light;
+} t_SimOccluder;
+
+/* Conveyor seen by both sensors: objects move with the belt while
+ * the motor runs, the color sensor spot and the ultrasonic beam
+ * average over what lies under them
+ */
+class BeltScene
+{
+public:
+    double speed = 100.0;         /* Belt speed in mm/s while the motor runs */
+    double beltDistance = 300.0;  /* Proximity sensor to empty belt, millimetres */
+    double distanceNoise = 2.0;   /* Sigma of distance readings, millimetres */
+    double colorSpot = 8.0;       /* Width of color sensor field of view on the belt */
+    double colorPosition;         /* Position of color sensor, SENSOR_SPACING by default */
+    t_SimLight beltLight = {100.0, 30.0, 30.0, 30.0};
+    bool motorOn = false;
+
+    BeltScene();
+
+    /* Put an object on the belt, its front at the given position */
+    void add(double front, double length, double height, t_SimLight light);
+    void addOccluder(uint32_t start, uint32_t end, t_SimLight light);
+
+    /* Move the belt up to the given time */
+    void advanceTo(uint64_t nowUs);
+
+    /* Sensor inputs at the given time */
+    int distance(uint64_t timeUs);
+    t_SimLight light(uint64_t timeUs);
+
+    std::vector<t_SimObject> objects;
+
+private:
+    std::vector<t_SimOccluder> occluders;
+    uint64_t lastUs = 0;
+    uint32_t random = 0x9E3779B9;
+
+    double gaussian(void);
+};
+
+/* Light of a matte colored object seen by the sensor, from its
+ * normalized color (0-255 per channel, like normalizeRGB())
+ * and brightness (clear counts per 2.4 ms step at 1x gain)
+ */
+t_SimLight BeltScene_colorLight(uint8_t red, uint8_t green, uint8_t blue, double clear);
+
+#endif /* BELTSCENE_H */
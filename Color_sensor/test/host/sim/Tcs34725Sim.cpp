@@ -0,0 +1,221 @@
+#include "FakeArduino.h"
+#include "Tcs34725Sim.h"
+
+#define TCS_ENABLE 0x00
+#define TCS_ATIME 0x01
+#define TCS_AILTL 0x04
+#define TCS_AIHTL 0x06
+#define TCS_PERS 0x0C
+#define TCS_CONTROL 0x0F
+#define TCS_ID 0x12
+#define TCS_STATUS 0x13
+#define TCS_CDATAL 0x14
+
+#define TCS_ENABLE_PON 0x01
+#define TCS_ENABLE_AEN 0x02
+#define TCS_ENABLE_AIEN 0x10
+
+#define TCS_STEP_US 2400
+#define TCS_INIT_US 2400 /* RGBC init after AEN is set, before the first cycle */
+
+/* Out-of-window cycles before AINT, by PERS value (0: every cycle) */
+static const uint8_t Tcs34725Sim_persistence[16] = {0, 1, 2, 3, 5, 10, 15, 20, 25, 30, 35, 40, 45, 50, 55, 60};
+
+Tcs34725Sim::Tcs34725Sim(uint8_t intPin) : intPin(intPin)
+{
+    memset(regs, 0, sizeof(regs));
+    regs[TCS_ATIME] = 0xFF;
+    regs[TCS_ID] = 0x44;
+}
+
+void Tcs34725Sim::setLight(std::function<t_SimLight(uint64_t)> source)
+{
+    light = source;
+}
+
+double Tcs34725Sim::gaussian(void)
+{
+    /* Sum of uniforms (Irwin-Hall), deterministic */
+    double sum = 0.0;
+    for (uint8_t i = 0; i < 12; i++)
+    {
+        random = (random * 1664525u) + 1013904223u;
+        sum += (double)(random >> 8) / (double)(1u << 24);
+    }
+    return sum - 6.0;
+}
+
+void Tcs34725Sim::startCycle(uint64_t timeUs)
+{
+    cycleStart = timeUs;
+    cycleSteps = 256 - regs[TCS_ATIME];
+    cycleGain = regs[TCS_CONTROL] & 0x03;
+}
+
+void Tcs34725Sim::completeCycle(uint64_t endUs)
+{
+    static const double gains[4] = {1.0, 4.0, 16.0, 60.0};
+
+    /* Average light over the cycle */
+    t_SimLight sum = {0.0, 0.0, 0.0, 0.0};
+    uint64_t duration = (uint64_t)cycleSteps * TCS_STEP_US;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        t_SimLight sample = light ? light(cycleStart + ((duration * ((2 * i) + 1)) / 8)) : t_SimLight{0.0, 0.0, 0.0, 0.0};
+        sum.clear += sample.clear / 4;
+        sum.red += sample.red / 4;
+        sum.green += sample.green / 4;
+        sum.blue += sample.blue / 4;
+    }
+
+    double scale = cycleSteps * gains[cycleGain];
+    double maxCount = (cycleSteps >= 64) ? 65535.0 : (1024.0 * cycleSteps);
+    double channels[4] = {sum.clear, sum.red, sum.green, sum.blue};
+
+    for (uint8_t ch = 0; ch < 4; ch++)
+    {
+        double count = channels[ch] * scale * (1.0 + (noise * gaussian()));
+        if (count < 0.0)
+            count = 0.0;
+        if (count > maxCount)
+            count = maxCount;
+        data[ch] = (uint16_t)lround(count);
+    }
+
+    valid = true;
+    cycles++;
+
+    /* Clear-channel interrupt with persistence filter */
+    if (regs[TCS_ENABLE] & TCS_ENABLE_AIEN)
+    {
+        uint16_t low = regs[TCS_AILTL] | (regs[TCS_AILTL + 1] << 8);
+        uint16_t high = regs[TCS_AIHTL] | (regs[TCS_AIHTL + 1] << 8);
+        uint8_t required = Tcs34725Sim_persistence[regs[TCS_PERS] & 0x0F];
+
+        if ((data[0] < low) || (data[0] > high))
+        {
+            if (outOfWindow < 255)
+                outOfWindow++;
+        }
+        else
+            outOfWindow = 0;
+
+        if ((required == 0) || (outOfWindow >= required))
+            interrupt = true;
+    }
+
+    updateIntPin();
+    startCycle(endUs);
+}
+
+void Tcs34725Sim::update(uint64_t nowUs)
+{
+    while (running && (nowUs >= (cycleStart + ((uint64_t)cycleSteps * TCS_STEP_US))))
+        completeCycle(cycleStart + ((uint64_t)cycleSteps * TCS_STEP_US));
+}
+
+void Tcs34725Sim::updateIntPin(void)
+{
+    bool low = interrupt && (regs[TCS_ENABLE] & TCS_ENABLE_AIEN);
+
+    if (low && !intLow)
+        intAssertions++;
+
+    intLow = low;
+    Fake_setPin(intPin, low ? LOW : HIGH);
+}
+
+void Tcs34725Sim::writeRegister(uint8_t reg, uint8_t value)
+{
+    reg &= 0x1F;
+
+    if (reg == TCS_ENABLE)
+    {
+        bool wasRunning = (regs[TCS_ENABLE] & (TCS_ENABLE_PON | TCS_ENABLE_AEN)) == (TCS_ENABLE_PON | TCS_ENABLE_AEN);
+        bool run = (value & (TCS_ENABLE_PON | TCS_ENABLE_AEN)) == (TCS_ENABLE_PON | TCS_ENABLE_AEN);
+
+        regs[TCS_ENABLE] = value;
+
+        /* AEN rising starts a new cycle after init, falling discards the running one and AVALID */
+        if (run && !wasRunning)
+            startCycle(Fake_micros() + TCS_INIT_US);
+        if (!run)
+            valid = false;
+        running = run;
+
+        updateIntPin();
+        return;
+    }
+
+    if ((reg == TCS_STATUS) || (reg == TCS_ID) || (reg >= TCS_CDATAL))
+        return; /* Read only */
+
+    regs[reg] = value;
+}
+
+uint8_t Tcs34725Sim::readRegister(uint8_t reg)
+{
+    reg &= 0x1F;
+
+    if (reg == TCS_STATUS)
+    {
+        statusReads++;
+        return (valid ? 0x01 : 0x00) | (interrupt ? 0x10 : 0x00);
+    }
+
+    if ((reg >= TCS_CDATAL) && (reg < (TCS_CDATAL + 8)))
+    {
+        uint16_t value = data[(reg - TCS_CDATAL) / 2];
+        return ((reg - TCS_CDATAL) & 1) ? (uint8_t)(value >> 8) : (uint8_t)(value & 0xFF);
+    }
+
+    return regs[reg];
+}
+
+bool Tcs34725Sim::write(const uint8_t * buffer, size_t length)
+{
+    update(Fake_micros());
+
+    if ((length == 0) || !(buffer[0] & 0x80))
+        return false;
+
+    uint8_t type = (buffer[0] >> 5) & 0x03;
+
+    /* Special function: clear channel interrupt clear */
+    if (type == 0x03)
+    {
+        if ((buffer[0] & 0x1F) == 0x06)
+        {
+            interrupt = false;
+            outOfWindow = 0;
+            updateIntPin();
+        }
+        return true;
+    }
+
+    pointer = buffer[0] & 0x1F;
+    autoIncrement = (type == 0x01);
+
+    for (size_t i = 1; i < length; i++)
+    {
+        writeRegister(pointer, buffer[i]);
+        if (autoIncrement)
+            pointer++;
+    }
+
+    return true;
+}
+
+bool Tcs34725Sim::read(uint8_t * buffer, size_t length)
+{
+    update(Fake_micros());
+
+    for (size_t i = 0; i < length; i++)
+    {
+        buffer[i] = readRegister(pointer);
+        if (autoIncrement)
+            pointer++;
+    }
+
+    return true;
+}
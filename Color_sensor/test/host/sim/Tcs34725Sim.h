@@ -0,0 +1,78 @@
+#ifndef TCS34725SIM_H
+#define TCS34725SIM_H
+
+#include "FakeI2C.h"
+
+/* Light reaching the sensor, in counts per 2.4 ms integration step at 1x gain */
+typedef struct
+{
+    double clear;
+    double red;
+    double green;
+    double blue;
+} t_SimLight;
+
+/* Register-level model of the TCS34725 behind the fake I2C bus:
+ * ENABLE (PON/AEN/AIEN), ATIME, CONTROL, clear-channel interrupt
+ * thresholds with persistence, STATUS and RGBC data. Integration
+ * cycles (after the 2.4 ms init when AEN is set) run on the simulated clock, the INT output (open drain,
+ * active low) drives a fake GPIO
+ */
+class Tcs34725Sim : public FakeI2CTarget
+{
+public:
+    explicit Tcs34725Sim(uint8_t intPin);
+
+    /* Light source, sampled over each integration cycle */
+    void setLight(std::function<t_SimLight(uint64_t timeUs)> light);
+
+    /* Relative noise (sigma) of every channel */
+    void setNoise(double sigma) { noise = sigma; }
+
+    /* Run integration cycles up to the given time */
+    void update(uint64_t nowUs);
+
+    bool write(const uint8_t * buffer, size_t length) override;
+    bool read(uint8_t * buffer, size_t length) override;
+
+    uint8_t enableRegister(void) const { return regs[0x00]; }
+    uint8_t integrationTime(void) const { return regs[0x01]; }
+    uint8_t gain(void) const { return regs[0x0F] & 0x03; }
+    bool interruptAsserted(void) const { return intLow; }
+    uint32_t interruptCount(void) const { return intAssertions; }
+    uint32_t cycleCount(void) const { return cycles; }
+    uint32_t statusReadCount(void) const { return statusReads; }
+
+private:
+    uint8_t regs[32];
+    uint8_t pointer = 0;
+    bool autoIncrement = false;
+
+    bool running = false;
+    uint64_t cycleStart = 0;
+    uint32_t cycleSteps = 0;
+    uint8_t cycleGain = 0;
+    uint16_t data[4] = {0, 0, 0, 0}; /* clear, red, green, blue */
+    bool valid = false;
+    bool interrupt = false;
+    uint8_t outOfWindow = 0;
+
+    uint8_t intPin;
+    bool intLow = false;
+    uint32_t intAssertions = 0;
+    uint32_t cycles = 0;
+    uint32_t statusReads = 0;
+
+    std::function<t_SimLight(uint64_t)> light;
+    double noise = 0.0;
+    uint32_t random = 0x2545F491;
+
+    void startCycle(uint64_t timeUs);
+    void completeCycle(uint64_t endUs);
+    void writeRegister(uint8_t reg, uint8_t value);
+    uint8_t readRegister(uint8_t reg);
+    void updateIntPin(void);
+    double gaussian(void);
+};
+
+#endif /* TCS34725SIM_H */
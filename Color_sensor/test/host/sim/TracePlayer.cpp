@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#include "TracePlayer.h"
+
+#define TRACE_STEP_US 2400
+
+/* Distance in time and in readings a saturated reading is replaced by an unsaturated one within */
+#define TRACE_SATURATION_SEARCH_MS 60
+#define TRACE_SATURATION_SEARCH_READINGS 8
+
+static double TracePlayer_gainFactor(uint8_t gain)
+{
+    static const double factors[4] = {1.0, 4.0, 16.0, 60.0};
+    return factors[gain & 0x03];
+}
+
+bool TracePlayer::load(const char * path)
+{
+    FILE * file = fopen(path, "r");
+    if (file == nullptr)
+        return false;
+
+    char line[160];
+    while (fgets(line, sizeof(line), file) != nullptr)
+    {
+        const char * trace = strstr(line, "trace ");
+        if (trace == nullptr)
+            continue;
+
+        char mode[16];
+        unsigned time, c, r, g, b, atime, gain, distance;
+
+        if (sscanf(trace, "trace color %u %u %u %u %u %u %u", &time, &c, &r, &g, &b, &atime, &gain) == 7)
+            colors.push_back({time, (uint16_t)c, (uint16_t)r, (uint16_t)g, (uint16_t)b, (uint8_t)atime, (uint8_t)gain});
+        else if (sscanf(trace, "trace distance %u %u", &time, &distance) == 2)
+            distances.push_back({time, (uint16_t)distance});
+        else if (sscanf(trace, "trace object %u %u %u %u", &time, &r, &g, &b) == 4)
+            objects.push_back({time, (uint8_t)r, (uint8_t)g, (uint8_t)b});
+        else if (sscanf(trace, "trace mode %15s", mode) == 1)
+            this->mode = (strcmp(mode, "flying") == 0) ? APP_CAPTURE_FLYING : APP_CAPTURE_STOP_AND_READ;
+    }
+
+    fclose(file);
+    return !colors.empty() && !distances.empty();
+}
+
+static bool TracePlayer_saturated(const t_TraceColor & reading)
+{
+    uint32_t steps = 256 - reading.integrationTime;
+    return reading.clear >= ((steps >= 64) ? 65535 : (1024 * steps));
+}
+
+t_SimLight TracePlayer::light(uint64_t timeUs) const
+{
+    /* Reading whose integration covers the time, else the one before (held while
+     * the application did not read, e.g. idle belt or stopped for a capture) */
+    uint32_t ms = (uint32_t)(timeUs / 1000);
+    auto next = std::lower_bound(colors.begin(), colors.end(), ms,
+            [](const t_TraceColor & reading, uint32_t time) { return reading.time < time; });
+
+    if (next == colors.end())
+        next = colors.end() - 1;
+    else if (next != colors.begin())
+    {
+        uint32_t steps = 256 - next->integrationTime;
+        uint64_t startUs = ((uint64_t)next->time * 1000) - ((uint64_t)steps * TRACE_STEP_US);
+        if (timeUs < startUs)
+            next--;
+    }
+
+    /* A saturated reading only bounds the light, the nearest unsaturated one stands in */
+    if (TracePlayer_saturated(*next))
+    {
+        size_t index = next - colors.begin(), nearest = index;
+        uint32_t nearestGap = TRACE_SATURATION_SEARCH_MS + 1;
+
+        for (size_t i = (index > TRACE_SATURATION_SEARCH_READINGS) ? (index - TRACE_SATURATION_SEARCH_READINGS) : 0;
+                (i < colors.size()) && (i <= (index + TRACE_SATURATION_SEARCH_READINGS)); i++)
+        {
+            uint32_t gap = (colors[i].time > next->time) ? (colors[i].time - next->time) : (next->time - colors[i].time);
+            if (!TracePlayer_saturated(colors[i]) && (gap < nearestGap))
+            {
+                nearest = i;
+                nearestGap = gap;
+            }
+        }
+
+        next = colors.begin() + nearest;
+    }
+
+    double scale = (256 - next->integrationTime) * TracePlayer_gainFactor(next->gain);
+    return {next->clear / scale, next->red / scale, next->green / scale, next->blue / scale};
+}
+
+int TracePlayer::distance(uint64_t timeUs) const
+{
+    uint32_t ms = (uint32_t)(timeUs / 1000);
+    auto next = std::lower_bound(distances.begin(), distances.end(), ms,
+            [](const t_TraceDistance & reading, uint32_t time) { return reading.time < time; });
+
+    if (next == distances.end())
+        next = distances.end() - 1;
+
+    return next->distance;
+}
+
+uint32_t TracePlayer::duration(void) const
+{
+    return std::max(colors.back().time, distances.back().time);
+}
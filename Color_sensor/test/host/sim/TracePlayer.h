@@ -0,0 +1,62 @@
+#ifndef TRACEPLAYER_H
+#define TRACEPLAYER_H
+
+#include <vector>
+
+#include "Application.h"
+#include "Tcs34725Sim.h"
+
+/* Raw color reading, as printed with APP_TRACE_READINGS */
+typedef struct
+{
+    uint32_t time; /* millis() of the reading, end of its integration */
+    uint16_t clear, red, green, blue;
+    uint8_t integrationTime;
+    uint8_t gain;  /* tcs34725Gain_t */
+} t_TraceColor;
+
+typedef struct
+{
+    uint32_t time;
+    uint16_t distance;
+} t_TraceDistance;
+
+/* Object that passed the color sensor: center under the sensor at time,
+ * normalized color it should be reported with
+ */
+typedef struct
+{
+    uint32_t time;
+    uint8_t red, green, blue;
+} t_TraceObject;
+
+/* Recorded sensor readings played back as the input of the device models.
+ *
+ * A trace is a text file of "trace ..." lines, other lines are ignored,
+ * so a Serial log of a board built with APP_TRACE_READINGS 1 works as is:
+ *   trace mode flying|stop                        capture mode of the recording
+ *   trace color <ms> <c> <r> <g> <b> <atime> <gain>
+ *   trace distance <ms> <mm>
+ *   trace object <ms> <r> <g> <b>                 expected detection (added by the recorder or by hand)
+ */
+class TracePlayer
+{
+public:
+    bool load(const char * path);
+
+    /* Light that gives the recorded counts, held between readings */
+    t_SimLight light(uint64_t timeUs) const;
+
+    /* First recorded distance at or after the given time (the answer to a request) */
+    int distance(uint64_t timeUs) const;
+
+    /* Time of the last reading */
+    uint32_t duration(void) const;
+
+    t_AppCaptureMode mode = APP_CAPTURE_STOP_AND_READ;
+    std::vector<t_TraceColor> colors;
+    std::vector<t_TraceDistance> distances;
+    std::vector<t_TraceObject> objects;
+};
+
+#endif /* TRACEPLAYER_H */
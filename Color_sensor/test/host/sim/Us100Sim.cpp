@@ -0,0 +1,58 @@
+#include "FakeArduino.h"
+#include "Us100Sim.h"
+
+#define US100_DISTANCE_COMMAND 0x55
+#define US100_TEMPERATURE_COMMAND 0x50
+
+#define US100_OVERHEAD_US 11000
+#define US100_ECHO_US_PER_MM 5.7
+
+Us100Sim::Us100Sim(HardwareSerial & uart) : uart(uart)
+{
+    uart.txHandler = [this](uint8_t value) { receive(value); };
+}
+
+void Us100Sim::setDistance(std::function<int(uint64_t)> source)
+{
+    distance = source;
+}
+
+void Us100Sim::receive(uint8_t command)
+{
+    /* A command while measuring is ignored, like the real module */
+    if (pending)
+        return;
+
+    uint64_t now = Fake_micros();
+
+    if (command == US100_DISTANCE_COMMAND)
+    {
+        requests++;
+
+        int mm = distance ? distance(now) : -1;
+        if (mm < 0)
+            return;
+
+        answer[0] = (uint8_t)(mm >> 8);
+        answer[1] = (uint8_t)(mm & 0xFF);
+        answerLength = 2;
+        dueUs = now + US100_OVERHEAD_US + (uint64_t)(US100_ECHO_US_PER_MM * mm);
+        pending = true;
+    }
+    else if (command == US100_TEMPERATURE_COMMAND)
+    {
+        answer[0] = 45 + 25;
+        answerLength = 1;
+        dueUs = now + US100_OVERHEAD_US;
+        pending = true;
+    }
+}
+
+void Us100Sim::update(uint64_t nowUs)
+{
+    if (!pending || (nowUs < dueUs))
+        return;
+
+    pending = false;
+    uart.inject(answer, answerLength);
+}
@@ -0,0 +1,37 @@
+#ifndef US100SIM_H
+#define US100SIM_H
+
+#include <Arduino.h>
+
+/* Model of the US-100 in UART mode behind a fake serial port:
+ * 0x55 triggers a measurement answered with 2 bytes of distance
+ * (millimetres, big endian) after ~11 ms plus the echo time,
+ * 0x50 a temperature answered with 1 byte
+ */
+class Us100Sim
+{
+public:
+    explicit Us100Sim(HardwareSerial & uart);
+
+    /* Distance source in millimetres, negative for no echo (no answer) */
+    void setDistance(std::function<int(uint64_t timeUs)> distance);
+
+    /* Deliver answers that are due */
+    void update(uint64_t nowUs);
+
+    uint32_t requestCount(void) const { return requests; }
+
+private:
+    HardwareSerial & uart;
+    std::function<int(uint64_t)> distance;
+
+    bool pending = false;
+    uint64_t dueUs = 0;
+    uint8_t answer[2];
+    uint8_t answerLength = 0;
+    uint32_t requests = 0;
+
+    void receive(uint8_t command);
+};
+
+#endif /* US100SIM_H */
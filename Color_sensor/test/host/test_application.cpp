@@ -0,0 +1,353 @@
+#include <unistd.h>
+
+#include "FakeArduino.h"
+#include "Preferences.h"
+#include "AppSim.h"
+#include "Calib.h"
+#include "HostTest.h"
+
+/* Normalized colors of the test objects and the empty belt (76, 76, 76) */
+static const t_SimLight SIM_RED = BeltScene_colorLight(170, 51, 42, 60.0);
+static const t_SimLight SIM_GREEN = BeltScene_colorLight(45, 160, 60, 70.0);
+static const t_SimLight SIM_BLUE = BeltScene_colorLight(40, 70, 150, 50.0);
+
+/* Boot and wait until the belt runs */
+static void App_bootAndStart(AppSim & sim)
+{
+    sim.boot();
+    CHECK(sim.runUntil([&] { return sim.motor; }, 5000));
+}
+
+TEST(boot_calibrates_and_starts_motor)
+{
+    AppSim sim;
+    App_bootAndStart(sim);
+
+    t_AppBaseline baseline;
+    App_getBaseline(&baseline);
+    CHECK_NEAR(baseline.distance, 300, 3);
+    CHECK_NEAR(baseline.color.red, 76, 2);
+    CHECK_NEAR(baseline.color.green, 76, 2);
+    CHECK_NEAR(baseline.color.blue, 76, 2);
+    CHECK_EQ(baseline.flags, 0);
+
+    t_AppStartupReport report;
+    App_getStartupReport(&report);
+    CHECK(!report.profileRestored);
+    CHECK(report.readyTime > 0);
+
+    /* Nothing on the belt: no detection, motor keeps running */
+    sim.run(5000);
+    CHECK_EQ(sim.detections.size(), 0);
+    CHECK(sim.motor);
+}
+
+TEST(empty_belt_runs_only_on_sensor_events)
+{
+    AppSim sim;
+    App_bootAndStart(sim);
+
+    /* A run per distance reply (one every 12.7 ms at 300 mm) and per
+     * baseline reading of the color sensor, no polling in between */
+    uint32_t runs = sim.appRuns;
+    sim.run(10000);
+    CHECK(sim.appRuns - runs <= (10000 / 12) + (10000 / COLOR_BASELINE_PERIOD));
+    CHECK_EQ(sim.detections.size(), 0);
+}
+
+TEST(motor_stays_off_until_startup_complete)
+{
+    AppSim sim;
+    sim.startupComplete = false;
+    sim.boot();
+    sim.run(3000);
+    CHECK(!sim.motor);
+    CHECK_EQ(sim.motorEvents.size(), 0);
+
+    /* Sensors calibrated meanwhile, without the network */
+    t_AppStartupReport report;
+    App_getStartupReport(&report);
+    CHECK(report.readyTime > 0);
+    CHECK(report.readyTime < 3000);
+
+    /* Belt starts as soon as the network and time are up */
+    sim.startupComplete = true;
+    CHECK(sim.runUntil([&] { return sim.motor; }, 10));
+}
+
+TEST(detects_object_with_color_and_height)
+{
+    AppSim sim;
+    App_bootAndStart(sim);
+    uint32_t start = millis();
+
+    sim.scene.add(-20.0, 40.0, 50.0, SIM_RED);
+    CHECK(sim.runUntil([&] { return !sim.detections.empty(); }, 5000));
+
+    const t_ObjectRecord & record = sim.detections[0].record;
+    CHECK_EQ(record.sequence, 1);
+    CHECK_NEAR(record.height, 50, 4);
+    CHECK_NEAR(record.color.red, 170, 4);
+    CHECK_NEAR(record.color.green, 51, 4);
+    CHECK_NEAR(record.color.blue, 42, 4);
+    CHECK_NEAR(record.color.clear, 60 * 40, 100); /* Counts per step at 1x, times 10 steps at 4x */
+
+    /* Front reaches the proximity sensor 0.2 s after start, the color sensor 1.5 s later */
+    CHECK_NEAR(record.timestamp, start + 200, 60);
+    CHECK(sim.detections[0].time > (record.timestamp + 1500));
+
+    /* Belt runs again after the capture */
+    sim.run(500);
+    CHECK(sim.motor);
+    CHECK_EQ(sim.detections.size(), 1);
+}
+
+TEST(detects_objects_in_order)
+{
+    AppSim sim;
+    App_bootAndStart(sim);
+
+    sim.scene.add(-20.0, 40.0, 50.0, SIM_RED);
+    sim.scene.add(-100.0, 30.0, 80.0, SIM_GREEN);
+    sim.scene.add(-180.0, 50.0, 30.0, SIM_BLUE);
+    CHECK(sim.runUntil([&] { return sim.detections.size() == 3; }, 15000));
+
+    const t_SimLight * lights[3] = {&SIM_RED, &SIM_GREEN, &SIM_BLUE};
+    const uint16_t heights[3] = {50, 80, 30};
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        const t_ObjectRecord & record = sim.detections[i].record;
+        CHECK_EQ(record.sequence, i + 1);
+        CHECK_NEAR(record.height, heights[i], 4);
+        CHECK_NEAR(record.color.red, lround(lights[i]->red * 255.0 / lights[i]->clear), 4);
+        CHECK_NEAR(record.color.green, lround(lights[i]->green * 255.0 / lights[i]->clear), 4);
+        CHECK_NEAR(record.color.blue, lround(lights[i]->blue * 255.0 / lights[i]->clear), 4);
+    }
+
+    /* Belt speed measured between the sensors */
+    t_BeltEstimate belt;
+    App_getBeltEstimate(&belt);
+    CHECK_NEAR(belt.speed, 100, 10);
+
+    sim.run(3000);
+    CHECK_EQ(sim.detections.size(), 3);
+}
+
+TEST(packed_belt_stop_and_read_keeps_center_timing)
+{
+    AppSim sim;
+    App_bootAndStart(sim);
+
+    /* A first object alone gives the belt speed the capture time is predicted with */
+    sim.scene.add(-20.0, 40.0, 50.0, SIM_RED);
+    CHECK(sim.runUntil([&] { return sim.detections.size() == 1; }, 5000));
+
+    /* 40 mm objects at 60 mm pitch: while the belt stops for one capture,
+     * the next ones are already on their way to the color sensor */
+    const t_SimLight * lights[3] = {&SIM_GREEN, &SIM_BLUE, &SIM_RED};
+    for (uint8_t i = 0; i < 6; i++)
+        sim.scene.add(-20.0 - (60.0 * i), 40.0, 50.0, *lights[i % 3]);
+    CHECK(sim.runUntil([&] { return sim.detections.size() == 7; }, 20000));
+
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        const t_ObjectRecord & record = sim.detections[i + 1].record;
+        const t_SimLight * light = lights[i % 3];
+        CHECK_EQ(record.sequence, i + 2);
+        CHECK_NEAR(record.color.red, lround(light->red * 255.0 / light->clear), 4);
+        CHECK_NEAR(record.color.green, lround(light->green * 255.0 / light->clear), 4);
+        CHECK_NEAR(record.color.blue, lround(light->blue * 255.0 / light->clear), 4);
+    }
+}
+
+TEST(color_interrupt_stays_armed_after_capture)
+{
+    AppSim sim;
+    App_bootAndStart(sim);
+
+    sim.scene.add(-20.0, 40.0, 50.0, SIM_RED);
+    CHECK(sim.runUntil([&] { return !sim.detections.empty(); }, 5000));
+    sim.run(1000);
+    CHECK(sim.colorSensor.enableRegister() & 0x10); /* AIEN */
+
+    /* Idle belt: the bus is left alone apart from baseline readings */
+    uint32_t transactions = FakeI2C_transactions(0x29);
+    sim.run(5000);
+    CHECK(FakeI2C_transactions(0x29) - transactions <= 20);
+
+    /* Hand in front of the color sensor only: INT wakes the application */
+    uint32_t interrupts = sim.colorSensor.interruptCount();
+    uint32_t now = millis();
+    sim.scene.addOccluder(now + 100, now + 600, BeltScene_colorLight(200, 40, 40, 40.0));
+    sim.run(200);
+    CHECK(sim.colorSensor.interruptCount() > interrupts);
+    sim.run(2000);
+    CHECK_EQ(sim.detections.size(), 1);
+    CHECK(sim.motor);
+}
+
+TEST(baseline_ignores_untracked_object)
+{
+    AppSim sim;
+    App_bootAndStart(sim);
+
+    t_AppBaseline before;
+    App_getBaseline(&before);
+
+    /* Red card held in front of the color sensor only, the proximity sensor sees nothing */
+    uint32_t now = millis();
+    sim.scene.addOccluder(now, now + 20000, BeltScene_colorLight(170, 51, 42, 60.0));
+    sim.run(20000);
+
+    t_AppBaseline after;
+    App_getBaseline(&after);
+    CHECK_NEAR(after.color.red, before.color.red, 1);
+    CHECK_NEAR(after.color.green, before.color.green, 1);
+    CHECK_NEAR(after.color.blue, before.color.blue, 1);
+    CHECK_NEAR(after.clear, before.clear, before.clear / 100);
+    CHECK_EQ(after.flags, 0);
+    CHECK(sim.detections.empty());
+
+    /* Still tracks the empty belt afterwards */
+    sim.scene.beltLight = BeltScene_colorLight(80, 76, 72, 100.0);
+    sim.run(60000);
+    App_getBaseline(&after);
+    CHECK_NEAR(after.color.red, 80, 2);
+    CHECK_NEAR(after.color.blue, 72, 2);
+}
+
+TEST(overheight_stops_motor_until_cleared)
+{
+    AppSim sim;
+    App_bootAndStart(sim);
+
+    /* Top of the object 25 mm from the sensor, below OVERHEIGHT_LIMIT */
+    sim.scene.add(-20.0, 60.0, 275.0, SIM_RED);
+    CHECK(sim.runUntil([&] { return !sim.overheights.empty(); }, 3000));
+    CHECK(!sim.motor);
+    CHECK(App_getOverheightCondition());
+
+    /* Belt stopped with the object under the sensor */
+    sim.run(2000);
+    CHECK(!sim.motor);
+    CHECK_EQ(sim.overheights.size(), 1);
+
+    /* Object taken off the belt */
+    uint32_t removed = millis();
+    sim.scene.objects.clear();
+    CHECK(sim.runUntil([&] { return sim.motor; }, 2000));
+    CHECK(!App_getOverheightCondition());
+
+    /* The relay never switched on while overheight, nor before the object was removed */
+    for (const t_SimMotorEvent & event : sim.motorEvents)
+    {
+        CHECK(!(event.on && event.overheight));
+        CHECK(!(event.on && (event.time >= sim.overheights[0]) && (event.time < removed)));
+    }
+}
+
+TEST(overheight_during_capture_keeps_motor_stopped)
+{
+    AppSim sim;
+    App_bootAndStart(sim);
+
+    /* Belt stops for the capture of a dark object (101 ms exposure) */
+    sim.scene.add(-20.0, 40.0, 50.0, BeltScene_colorLight(60, 60, 120, 1.0));
+    CHECK(sim.runUntil([&] { return !sim.motor; }, 5000));
+    CHECK(sim.detections.empty());
+
+    /* Meanwhile a tall object is put under the proximity sensor */
+    sim.scene.add(20.0, 60.0, 275.0, SIM_GREEN);
+    CHECK(sim.runUntil([&] { return !sim.detections.empty(); }, 2000));
+    CHECK(sim.runUntil([&] { return !sim.overheights.empty(); }, 2000));
+
+    /* Capture over, overheight keeps the belt stopped */
+    sim.run(1000);
+    CHECK(!sim.motor);
+    for (const t_SimMotorEvent & event : sim.motorEvents)
+        CHECK(!(event.on && event.overheight));
+}
+
+static char App_nvsPath[64];
+
+static void App_calibrateAndSave(void)
+{
+    AppSim sim;
+    App_bootAndStart(sim);
+    CHECK(FakeNvs_save(App_nvsPath));
+}
+
+TEST(saved_profile_skips_calibration)
+{
+    snprintf(App_nvsPath, sizeof(App_nvsPath), "/tmp/color_sensor_nvs_%d.bin", (int)getpid());
+
+    /* First boot calibrates and saves the profile */
+    CHECK(HostTest_runChild(App_calibrateAndSave));
+
+    /* Second boot on the same flash */
+    CHECK(FakeNvs_load(App_nvsPath));
+    remove(App_nvsPath);
+
+    AppSim sim;
+    App_bootAndStart(sim);
+
+    t_AppStartupReport report;
+    App_getStartupReport(&report);
+    CHECK(report.profileRestored);
+    CHECK(report.readyTime < 200);
+
+    sim.scene.add(-20.0, 40.0, 50.0, SIM_RED);
+    CHECK(sim.runUntil([&] { return !sim.detections.empty(); }, 5000));
+    CHECK_NEAR(sim.detections[0].record.color.red, 170, 4);
+}
+
+TEST(outdated_profile_calibrates_again)
+{
+    snprintf(App_nvsPath, sizeof(App_nvsPath), "/tmp/color_sensor_nvs_%d.bin", (int)getpid());
+    CHECK(HostTest_runChild(App_calibrateAndSave));
+    CHECK(FakeNvs_load(App_nvsPath));
+    remove(App_nvsPath);
+
+    /* Belt moved 40 mm away from the sensor since */
+    AppSim sim;
+    sim.scene.beltDistance = 340.0;
+    App_bootAndStart(sim);
+
+    t_AppStartupReport report;
+    App_getStartupReport(&report);
+    CHECK(!report.profileRestored);
+
+    t_AppBaseline baseline;
+    App_getBaseline(&baseline);
+    CHECK_NEAR(baseline.distance, 340, 3);
+}
+
+TEST(flying_capture_compares_clear_at_preview_exposure)
+{
+    AppSim sim;
+    App_setCaptureMode(APP_CAPTURE_FLYING);
+    App_bootAndStart(sim);
+
+    /* Short objects, so capture samples run past them onto the belt:
+     * the bright one saturates preview exposure and is captured at 1x gain,
+     * the dark one is captured at 16x gain where the belt saturates */
+    const t_SimLight bright = BeltScene_colorLight(200, 190, 60, 300.0);
+    const t_SimLight dark = BeltScene_colorLight(40, 70, 150, 20.0);
+    sim.scene.add(-20.0, 15.0, 50.0, bright);
+    sim.scene.add(-90.0, 15.0, 50.0, dark);
+    CHECK(sim.runUntil([&] { return sim.detections.size() == 2; }, 5000));
+
+    const t_SimLight * lights[2] = {&bright, &dark};
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        const t_ObjectRecord & record = sim.detections[i].record;
+        CHECK_NEAR(record.color.red, lround(lights[i]->red * 255.0 / lights[i]->clear), 4);
+        CHECK_NEAR(record.color.green, lround(lights[i]->green * 255.0 / lights[i]->clear), 4);
+        CHECK_NEAR(record.color.blue, lround(lights[i]->blue * 255.0 / lights[i]->clear), 4);
+        CHECK_NEAR(record.color.clear, lights[i]->clear * 40, lights[i]->clear * 2);
+    }
+
+    /* Capture over once the object left, not after all COLOR_FLYING_CAPTURE_SAMPLES */
+    CHECK(sim.detections[1].time < (sim.detections[1].record.timestamp + 1500 + 300));
+}
@@ -0,0 +1,56 @@
+#include "ColorClassifier.h"
+#include "HostTest.h"
+
+static uint8_t Classifier_class(uint8_t red, uint8_t green, uint8_t blue)
+{
+    t_Color color = {red, green, blue, 0, 0, 0};
+    ColorClassifier_classify(&color);
+    return color.classId;
+}
+
+TEST(lookup_matches_exact_for_every_color)
+{
+    ColorClassifier_init();
+
+    for (uint32_t rgb = 0; rgb < (1U << 24); rgb++)
+    {
+        t_Color lut = {(uint8_t)(rgb >> 16), (uint8_t)(rgb >> 8), (uint8_t)rgb, 0, 0, 0};
+        t_Color exact = lut;
+        ColorClassifier_classify(&lut);
+        ColorClassifier_classifyExact(&exact);
+        if (lut.classId != exact.classId)
+            CHECK_EQ(rgb, 0); /* Report the first color that differs */
+    }
+}
+
+TEST(taught_centroids_replace_the_table)
+{
+    static const t_ColorCentroid centroids[] = {{7, 200, 30, 25}, {9, 30, 70, 155}};
+
+    ColorClassifier_init();
+    CHECK_EQ(Classifier_class(198, 32, 25), 1);
+
+    ColorClassifier_setCentroids(centroids, 2);
+    CHECK_EQ(Classifier_class(198, 32, 25), 7);
+    CHECK_EQ(Classifier_class(32, 68, 150), 9);
+    CHECK_EQ(Classifier_class(40, 160, 55), COLOR_CLASS_NONE); /* Green is no longer taught */
+}
+
+TEST(lookup_matches_exact_with_two_centroids_per_class)
+{
+    /* Class 2 between two centroids of class 1: every corner of some cells
+     * is nearer to one of those, while class 2 wins inside the cell */
+    static const t_ColorCentroid centroids[] = {{1, 149, 198, 112}, {1, 129, 189, 112}, {2, 140, 202, 105}};
+
+    ColorClassifier_setCentroids(centroids, 3);
+
+    for (uint32_t rgb = 0; rgb < (1U << 24); rgb++)
+    {
+        t_Color lut = {(uint8_t)(rgb >> 16), (uint8_t)(rgb >> 8), (uint8_t)rgb, 0, 0, 0};
+        t_Color exact = lut;
+        ColorClassifier_classify(&lut);
+        ColorClassifier_classifyExact(&exact);
+        if (lut.classId != exact.classId)
+            CHECK_EQ(rgb, 0); /* Report the first color that differs */
+    }
+}
@@ -0,0 +1,256 @@
+#include "FakeArduino.h"
+#include "FakeFirebase.h"
+#include "FakeFlash.h"
+#include "FakeTime.h"
+#include "FirebaseDb.h"
+#include "Journal.h"
+#include "HostTest.h"
+
+/* Database task period of the sketch (DATABASE_JOB_PERIOD) */
+#define DB_TASK_PERIOD 10
+
+static void Db_run(uint32_t ms)
+{
+    for (uint32_t elapsed = 0; elapsed < ms; elapsed += DB_TASK_PERIOD)
+    {
+        Fake_advance(DB_TASK_PERIOD * 1000);
+        Database_task();
+    }
+}
+
+static void Db_setUp(void)
+{
+    Fake_reset();
+    FakeFlash_format();
+    FakeFirebase_reset();
+    FakeTime_set(1700000000000ULL);
+    Database_setUploadMode(DATABASE_UPLOAD_RAW);
+}
+
+static void Db_connect(void)
+{
+    Db_run(100);
+    CHECK_EQ(Database_getState(), FIREBASE_CONNECTED);
+}
+
+static void Db_enqueue(uint32_t sequence)
+{
+    t_ObjectRecord record;
+    memset(&record, 0, sizeof(record));
+    record.sequence = sequence;
+    record.timestamp = millis();
+    record.height = 40;
+    record.color = {(uint8_t)(100 + sequence), 50, 40, 3000, COLOR_CLASS_NONE, 0};
+    CHECK(Database_enqueueObject(&record));
+}
+
+/* Requests to a node and below (metrics are uploaded too) */
+static std::vector<t_FakeFirebaseRequest> Db_requests(const std::string & node)
+{
+    std::vector<t_FakeFirebaseRequest> requests;
+    for (const t_FakeFirebaseRequest & request : FakeFirebase_requests())
+    {
+        if (request.path.compare(0, node.size(), node) == 0)
+            requests.push_back(request);
+    }
+    return requests;
+}
+
+TEST(records_uploaded_in_legacy_schema_by_default)
+{
+    Db_setUp();
+    Db_connect();
+
+    Db_enqueue(1);
+    Db_run(2000);
+
+    CHECK_EQ(FakeFirebase_children("/Data").size(), 4); /* color, timestamp, user, status */
+
+    uint32_t colors = 0;
+    for (const auto & child : FakeFirebase_children("/Data"))
+    {
+        if ((child.first.size() > 6) && (child.first.compare(child.first.size() - 6, 6, "/color") == 0))
+        {
+            CHECK(child.second == "\"101,50,40\"");
+            colors++;
+        }
+    }
+    CHECK_EQ(colors, 1);
+}
+
+TEST(records_uploaded_in_one_batch)
+{
+    Db_setUp();
+    Database_setRecordSchema(DATABASE_SCHEMA_COMPACT);
+    Db_connect();
+
+    for (uint32_t i = 1; i <= 3; i++)
+        Db_enqueue(i);
+    Db_run(2000);
+
+    CHECK_EQ(FakeFirebase_children("/Data").size(), 3 * 5); /* r, g, b, c, t */
+    CHECK_EQ(FakeFirebase_requests().size(), 1);
+
+    /* Clear channel count of the capture, beyond 8 bits */
+    uint32_t clears = 0;
+    for (const auto & child : FakeFirebase_children("/Data"))
+    {
+        if ((child.first.size() > 2) && (child.first.compare(child.first.size() - 2, 2, "/c") == 0))
+        {
+            CHECK_EQ(atoi(child.second.c_str()), 3000);
+            clears++;
+        }
+    }
+    CHECK_EQ(clears, 3);
+
+    t_DatabaseStats stats;
+    Database_getStats(&stats);
+    CHECK_EQ(stats.sent, 3);
+    CHECK_EQ(stats.dropped, 0);
+    FakeFlash_erase();
+}
+
+TEST(live_records_out_of_retries_are_journaled)
+{
+    Db_setUp();
+    Db_connect();
+
+    FakeFirebase_failNext(5, false);
+    Db_enqueue(1);
+    Db_enqueue(2);
+    Db_run(10000);
+
+    t_DatabaseStats stats;
+    Database_getStats(&stats);
+    CHECK_EQ(stats.sent, 0);
+    CHECK_EQ(stats.journaled, 2);
+    CHECK_EQ(stats.dropped, 0);
+    CHECK(Journal_pending());
+
+    /* Replayed once the backoff is over */
+    Db_run(40000);
+    Database_getStats(&stats);
+    CHECK_EQ(stats.sent, 2);
+    CHECK_EQ(stats.dropped, 0);
+    CHECK(!Journal_pending());
+    CHECK_EQ(FakeFirebase_children("/Data").size(), 2 * 4);
+    FakeFlash_erase();
+}
+
+TEST(replayed_batch_out_of_retries_stays_in_journal)
+{
+    Db_setUp();
+
+    /* Offline: records go to the journal */
+    FakeFirebase_setReady(false);
+    Db_run(100);
+    for (uint32_t i = 1; i <= 3; i++)
+        Db_enqueue(i);
+
+    t_DatabaseStats stats;
+    Database_getStats(&stats);
+    CHECK_EQ(stats.journaled, 3);
+
+    /* Back online, but every attempt of the replayed batch fails */
+    FakeFirebase_setReady(true);
+    FakeFirebase_failNext(5, false);
+    Db_run(10000);
+
+    Database_getStats(&stats);
+    CHECK_EQ(stats.sent, 0);
+    CHECK_EQ(stats.dropped, 0);
+    CHECK(Journal_pending());
+
+    /* Replayed again and committed once uploaded */
+    Db_run(40000);
+    Database_getStats(&stats);
+    CHECK_EQ(stats.sent, 3);
+    CHECK_EQ(stats.dropped, 0);
+    CHECK(!Journal_pending());
+    CHECK_EQ(FakeFirebase_children("/Data").size(), 3 * 4);
+
+    /* Journal survives a reboot with nothing left to replay */
+    CHECK(Journal_init(&Journal_flashStorage));
+    CHECK(!Journal_pending());
+    FakeFlash_erase();
+}
+
+TEST(journal_replayed_under_steady_detections)
+{
+    Db_setUp();
+
+    /* Offline: records go to the journal */
+    FakeFirebase_setReady(false);
+    Db_run(100);
+    for (uint32_t i = 1; i <= 3; i++)
+        Db_enqueue(i);
+
+    /* Back online with a detection before every run of the task,
+     * the upload queue is never empty when the task looks at it */
+    FakeFirebase_setReady(true);
+    for (uint32_t i = 4; i <= 200; i++)
+    {
+        Db_enqueue(i);
+        Db_run(DB_TASK_PERIOD);
+    }
+
+    CHECK(!Journal_pending());
+
+    Db_run(2000);
+    t_DatabaseStats stats;
+    Database_getStats(&stats);
+    CHECK_EQ(stats.sent, 200);
+    CHECK_EQ(stats.dropped, 0);
+    CHECK_EQ(FakeFirebase_children("/Data").size(), 200 * 4);
+    FakeFlash_erase();
+}
+
+TEST(counts_retried_after_ambiguous_failure_are_not_doubled)
+{
+    Db_setUp();
+    Database_setUploadMode(DATABASE_UPLOAD_AGGREGATE);
+    Db_connect();
+
+    for (uint32_t i = 1; i <= 3; i++)
+        Db_enqueue(i);
+
+    /* Server writes the first flush but the answer is lost, the retry sends it again */
+    FakeFirebase_failNext(1, true);
+    Db_run(70000);
+
+    std::vector<t_FakeFirebaseRequest> flushes = Db_requests("/Counts");
+    CHECK_EQ(flushes.size(), 2);
+    CHECK(flushes[0].applied);
+    CHECK(flushes[0].json == flushes[1].json);
+
+    /* Total of the minute is the sum over its flush keys */
+    uint32_t total = 0, classNone = 0;
+    for (const auto & child : FakeFirebase_children("/Counts"))
+    {
+        std::string name = child.first.substr(child.first.rfind('/') + 1);
+        if (name == "n")
+            total += atoi(child.second.c_str());
+        else if (name == std::to_string(COLOR_CLASS_NONE))
+            classNone += atoi(child.second.c_str());
+    }
+    CHECK_EQ(total, 3);
+    CHECK_EQ(classNone, 3);
+
+    /* Objects counted after the flush go under a new key of their minute */
+    Db_enqueue(4);
+    Db_run(70000);
+    CHECK_EQ(Db_requests("/Counts").size(), 3);
+
+    total = 0;
+    for (const auto & child : FakeFirebase_children("/Counts"))
+    {
+        if (child.first.substr(child.first.rfind('/') + 1) == "n")
+            total += atoi(child.second.c_str());
+    }
+    CHECK_EQ(total, 4);
+
+    t_DatabaseStats stats;
+    Database_getStats(&stats);
+    CHECK_EQ(stats.counted, 4);
+    CHECK_EQ(stats.dropped, 0);
+}
@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+
+#include "DetectionQueue.h"
+#include "HostTest.h"
+
+/* Records pushed through the queue by the stress test, about 12500 times its size */
+#define QUEUE_STRESS_RECORDS 200000
+
+/* Record whose every field derives from its sequence, so a torn copy shows */
+static t_ObjectRecord Queue_record(uint32_t sequence)
+{
+    t_ObjectRecord record;
+    memset(&record, 0, sizeof(record));
+    record.sequence = sequence;
+    record.timestamp = sequence * 3;
+    record.dwell = ~sequence;
+    record.height = (uint16_t)sequence;
+    record.epoch = sequence ^ 0x5A5A5A5A;
+    record.epochMs = (uint16_t)(sequence % 1000);
+    snprintf(record.key, sizeof(record.key), "%015u", sequence);
+    record.color = {(uint8_t)sequence, (uint8_t)(sequence >> 8), (uint8_t)(sequence >> 16), (uint16_t)(sequence * 7),
+            (uint8_t)(sequence % COLOR_CLASS_COUNT), (uint8_t)(sequence >> 3)};
+    return record;
+}
+
+static bool Queue_intact(const t_ObjectRecord * record, uint32_t sequence)
+{
+    t_ObjectRecord expected = Queue_record(sequence);
+    return memcmp(record, &expected, sizeof(expected)) == 0;
+}
+
+TEST(full_and_empty_across_index_wrap)
+{
+    static t_DetectionQueue queue;
+    DetectionQueue_init(&queue);
+
+    /* Free running indexes just before they wrap */
+    queue.head.store(UINT32_MAX - 4);
+    queue.tail.store(UINT32_MAX - 4);
+
+    t_ObjectRecord record;
+    CHECK(!DetectionQueue_pop(&queue, &record));
+    CHECK(DetectionQueue_peek(&queue) == nullptr);
+
+    for (uint32_t i = 0; i < DETECTION_QUEUE_SIZE; i++)
+    {
+        t_ObjectRecord pushed = Queue_record(i);
+        CHECK(DetectionQueue_push(&queue, &pushed));
+    }
+
+    t_ObjectRecord extra = Queue_record(DETECTION_QUEUE_SIZE);
+    CHECK(!DetectionQueue_push(&queue, &extra));
+    CHECK_EQ(DetectionQueue_count(&queue), DETECTION_QUEUE_SIZE);
+    CHECK(Queue_intact(DetectionQueue_peekAt(&queue, DETECTION_QUEUE_SIZE - 1), DETECTION_QUEUE_SIZE - 1));
+    CHECK(DetectionQueue_peekAt(&queue, DETECTION_QUEUE_SIZE) == nullptr);
+
+    for (uint32_t i = 0; i < DETECTION_QUEUE_SIZE; i++)
+    {
+        CHECK(DetectionQueue_pop(&queue, &record));
+        CHECK(Queue_intact(&record, i));
+    }
+
+    CHECK(!DetectionQueue_pop(&queue, &record));
+    CHECK_EQ(DetectionQueue_count(&queue), 0);
+}
+
+TEST(producer_and_consumer_threads_keep_order_and_content)
+{
+    static t_DetectionQueue queue;
+    DetectionQueue_init(&queue);
+
+    std::atomic<uint32_t> full(0);
+
+    /* Producer as the sensor task: retries while the queue is full */
+    std::thread producer([&] {
+        for (uint32_t sequence = 0; sequence < QUEUE_STRESS_RECORDS; sequence++)
+        {
+            t_ObjectRecord record = Queue_record(sequence);
+            while (!DetectionQueue_push(&queue, &record))
+            {
+                full.fetch_add(1, std::memory_order_relaxed);
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    /* Consumer as the network task: looks at waiting records before removing them */
+    uint32_t expected = 0, torn = 0, outOfOrder = 0, empty = 0;
+    while (expected < QUEUE_STRESS_RECORDS)
+    {
+        uint32_t count = DetectionQueue_count(&queue);
+        if (count == 0)
+        {
+            empty++;
+            std::this_thread::yield();
+            continue;
+        }
+
+        const t_ObjectRecord * last = DetectionQueue_peekAt(&queue, count - 1);
+        if ((last == nullptr) || !Queue_intact(last, expected + count - 1))
+            torn++;
+
+        t_ObjectRecord record;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (!DetectionQueue_pop(&queue, &record))
+                break;
+            if (record.sequence != expected)
+                outOfOrder++;
+            else if (!Queue_intact(&record, expected))
+                torn++;
+            expected = record.sequence + 1;
+        }
+    }
+
+    producer.join();
+
+    printf("%u records, producer found the queue full %u times, consumer found it empty %u times\n",
+            expected, full.load(), empty);
+    CHECK_EQ(outOfOrder, 0);
+    CHECK_EQ(torn, 0);
+    CHECK_EQ(DetectionQueue_count(&queue), 0);
+}
@@ -0,0 +1,213 @@
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "Journal.h"
+#include "FakeFlash.h"
+#include "HostTest.h"
+
+#define JOURNAL_TEST_SEGMENT_RECORDS 64
+
+static t_ObjectRecord Journal_testRecord(uint32_t sequence)
+{
+    t_ObjectRecord record;
+    memset(&record, 0, sizeof(record));
+    record.sequence = sequence;
+    record.timestamp = sequence * 100;
+    record.height = (uint16_t)(sequence % 200);
+    snprintf(record.key, sizeof(record.key), "K%014u", sequence);
+    return record;
+}
+
+static void Journal_appendRange(uint32_t first, uint32_t last)
+{
+    for (uint32_t sequence = first; sequence <= last; sequence++)
+    {
+        t_ObjectRecord record = Journal_testRecord(sequence);
+        CHECK(Journal_append(&record));
+    }
+}
+
+/* Replay everything, committing batch by batch as the uploader does */
+static std::vector<uint32_t> Journal_drain(void)
+{
+    std::vector<uint32_t> sequences;
+    t_ObjectRecord batch[8];
+
+    while (Journal_pending())
+    {
+        uint16_t count = Journal_read(batch, 8);
+        for (uint16_t i = 0; i < count; i++)
+            sequences.push_back(batch[i].sequence);
+        Journal_commit();
+    }
+
+    return sequences;
+}
+
+/* Replay and commit a number of records */
+static void Journal_consume(uint32_t records)
+{
+    t_ObjectRecord batch[8];
+
+    while (records > 0)
+    {
+        uint16_t count = Journal_read(batch, (records < 8) ? (uint16_t)records : 8);
+        CHECK(count > 0);
+        Journal_commit();
+        records -= count;
+    }
+}
+
+/* Every record of [first, last] present once, in order, duplicates of a replay allowed */
+static void Journal_checkRange(const std::vector<uint32_t> & sequences, uint32_t first, uint32_t last)
+{
+    uint32_t expected = first;
+    for (uint32_t sequence : sequences)
+    {
+        if (sequence < expected)
+            continue; /* Replayed again after a cursor one commit behind */
+        CHECK_EQ(sequence, expected);
+        expected++;
+    }
+    CHECK_EQ(expected, last + 1);
+}
+
+TEST(records_survive_reboot)
+{
+    FakeFlash_format();
+    CHECK(Journal_init(&Journal_flashStorage));
+    CHECK(!Journal_pending());
+
+    Journal_appendRange(1, 150);
+    Journal_consume(20);
+
+    /* Reboot */
+    CHECK(Journal_init(&Journal_flashStorage));
+    CHECK(Journal_pending());
+    std::vector<uint32_t> sequences = Journal_drain();
+    CHECK_EQ(sequences.size(), 130);
+    Journal_checkRange(sequences, 21, 150);
+    CHECK_EQ(Journal_getDropped(), 0);
+
+    /* Empty journal starts over from segment 0 */
+    CHECK(!Journal_pending());
+    CHECK(!Journal_flashStorage.exists("/journal/2.bin"));
+    Journal_appendRange(151, 152);
+    CHECK(Journal_flashStorage.exists("/journal/0.bin"));
+    FakeFlash_erase();
+}
+
+TEST(torn_cursor_write_keeps_pending_segments)
+{
+    FakeFlash_format();
+    CHECK(Journal_init(&Journal_flashStorage));
+
+    /* Segments 0-3, the first two replayed */
+    Journal_appendRange(1, 4 * JOURNAL_TEST_SEGMENT_RECORDS);
+    Journal_consume(2 * JOURNAL_TEST_SEGMENT_RECORDS);
+
+    /* Power lost while the next cursor is written (removed, not created again) */
+    t_ObjectRecord batch[8];
+    CHECK_EQ(Journal_read(batch, 8), 8);
+    FakeFlash_tearNextWrite(0);
+    Journal_commit();
+
+    CHECK(Journal_init(&Journal_flashStorage));
+    std::vector<uint32_t> sequences = Journal_drain();
+    Journal_checkRange(sequences, (2 * JOURNAL_TEST_SEGMENT_RECORDS) + 1, 4 * JOURNAL_TEST_SEGMENT_RECORDS);
+    FakeFlash_erase();
+}
+
+TEST(partial_cursor_write_keeps_pending_segments)
+{
+    FakeFlash_format();
+    CHECK(Journal_init(&Journal_flashStorage));
+
+    Journal_appendRange(1, 4 * JOURNAL_TEST_SEGMENT_RECORDS);
+    Journal_consume(2 * JOURNAL_TEST_SEGMENT_RECORDS);
+
+    t_ObjectRecord batch[8];
+    CHECK_EQ(Journal_read(batch, 8), 8);
+    FakeFlash_tearNextWrite(5);
+    Journal_commit();
+
+    CHECK(Journal_init(&Journal_flashStorage));
+    std::vector<uint32_t> sequences = Journal_drain();
+    Journal_checkRange(sequences, (2 * JOURNAL_TEST_SEGMENT_RECORDS) + 1, 4 * JOURNAL_TEST_SEGMENT_RECORDS);
+    FakeFlash_erase();
+}
+
+TEST(lost_cursor_finds_lowest_segment)
+{
+    FakeFlash_format();
+    CHECK(Journal_init(&Journal_flashStorage));
+
+    /* Segments 0-1 replayed and removed */
+    Journal_appendRange(1, 4 * JOURNAL_TEST_SEGMENT_RECORDS);
+    Journal_consume((2 * JOURNAL_TEST_SEGMENT_RECORDS) + 8);
+    CHECK(!Journal_flashStorage.exists("/journal/1.bin"));
+
+    /* Both cursor slots gone: segments 2-3 are still found */
+    remove(FakeFlash_path("/journal/cursor0.bin"));
+    remove(FakeFlash_path("/journal/cursor1.bin"));
+
+    CHECK(Journal_init(&Journal_flashStorage));
+    std::vector<uint32_t> sequences = Journal_drain();
+    CHECK_EQ(sequences.size(), 2 * JOURNAL_TEST_SEGMENT_RECORDS);
+    Journal_checkRange(sequences, (2 * JOURNAL_TEST_SEGMENT_RECORDS) + 9, 4 * JOURNAL_TEST_SEGMENT_RECORDS);
+    FakeFlash_erase();
+}
+
+TEST(interrupted_commit_skips_removed_segments)
+{
+    FakeFlash_format();
+    CHECK(Journal_init(&Journal_flashStorage));
+
+    Journal_appendRange(1, 4 * JOURNAL_TEST_SEGMENT_RECORDS);
+
+    /* Segments removed by a commit, power lost before the cursor was saved */
+    remove(FakeFlash_path("/journal/0.bin"));
+    remove(FakeFlash_path("/journal/1.bin"));
+
+    CHECK(Journal_init(&Journal_flashStorage));
+    std::vector<uint32_t> sequences = Journal_drain();
+    CHECK_EQ(sequences.size(), 2 * JOURNAL_TEST_SEGMENT_RECORDS);
+    Journal_checkRange(sequences, (2 * JOURNAL_TEST_SEGMENT_RECORDS) + 1, 4 * JOURNAL_TEST_SEGMENT_RECORDS);
+    FakeFlash_erase();
+}
+
+TEST(torn_record_write_keeps_complete_entries)
+{
+    FakeFlash_format();
+    CHECK(Journal_init(&Journal_flashStorage));
+
+    Journal_appendRange(1, 10);
+    t_ObjectRecord record = Journal_testRecord(11);
+    FakeFlash_tearNextWrite(7);
+    CHECK(!Journal_append(&record));
+
+    /* Reboot: complete entries kept, appends go on in a fresh segment */
+    CHECK(Journal_init(&Journal_flashStorage));
+    Journal_appendRange(11, 12);
+    std::vector<uint32_t> sequences = Journal_drain();
+    CHECK_EQ(sequences.size(), 12);
+    Journal_checkRange(sequences, 1, 12);
+    FakeFlash_erase();
+}
+
+TEST(full_journal_drops_oldest_segment)
+{
+    FakeFlash_format();
+    CHECK(Journal_init(&Journal_flashStorage));
+
+    /* 32 segments of 64 records fit, the next record drops segment 0 */
+    Journal_appendRange(1, (32 * JOURNAL_TEST_SEGMENT_RECORDS) + 1);
+    CHECK_EQ(Journal_getDropped(), JOURNAL_TEST_SEGMENT_RECORDS);
+
+    CHECK(Journal_init(&Journal_flashStorage));
+    std::vector<uint32_t> sequences = Journal_drain();
+    CHECK_EQ(sequences.size(), (31 * JOURNAL_TEST_SEGMENT_RECORDS) + 1);
+    Journal_checkRange(sequences, JOURNAL_TEST_SEGMENT_RECORDS + 1, (32 * JOURNAL_TEST_SEGMENT_RECORDS) + 1);
+    FakeFlash_erase();
+}
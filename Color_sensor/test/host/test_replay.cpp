@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#include "FakeArduino.h"
+#include "AppSim.h"
+#include "TracePlayer.h"
+#include "HostTest.h"
+
+/* Time after the object reached the color sensor in which its detection
+ * counts, and color error it is still reported right with
+ */
+#define REPLAY_LATE_MS 1500
+#define REPLAY_COLOR_TOLERANCE 6
+
+/* Largest difference between the two capture modes for the same object:
+ * normalized color channels, clear count at preview exposure (percent) */
+#define REPLAY_MODE_COLOR_TOLERANCE 6
+#define REPLAY_MODE_CLEAR_TOLERANCE 5
+
+/* Colors of each run, written by the child process that replayed the trace */
+#define REPLAY_FLYING_COLORS "build/replay_flying.colors"
+#define REPLAY_STOP_AND_READ_COLORS "build/replay_stop_and_read.colors"
+
+typedef struct
+{
+    uint32_t objects;
+    uint32_t missed;     /* No detection in the window */
+    uint32_t wrongColor; /* Detected with a channel off by more than the tolerance */
+    uint32_t spurious;   /* Detection of no object */
+    uint32_t latencyMean;
+    uint32_t latencyMax; /* Object reaching the color sensor to detection callback, ms */
+    std::vector<t_Color> colors; /* Detected color of each object of the trace, in trace order */
+} t_ReplayReport;
+
+/* Run the application from boot on a recorded trace and compare
+ * its detections with the objects of the trace
+ */
+static t_ReplayReport Replay_run(const char * path)
+{
+    TracePlayer trace;
+    CHECK(trace.load(path));
+    CHECK(!trace.objects.empty());
+
+    AppSim sim;
+    sim.colorSensor.setNoise(0.0); /* Recorded counts are noisy already */
+    sim.colorSensor.setLight([&](uint64_t timeUs) { return trace.light(timeUs); });
+    sim.proximitySensor.setDistance([&](uint64_t timeUs) { return trace.distance(timeUs); });
+    App_setCaptureMode(trace.mode);
+    sim.boot();
+    sim.run(trace.duration());
+
+    t_ReplayReport report = {(uint32_t)trace.objects.size(), 0, 0, 0, 0, 0, {}};
+    std::vector<bool> matched(sim.detections.size(), false);
+    uint32_t latencySum = 0, detected = 0;
+
+    for (const t_TraceObject & object : trace.objects)
+    {
+        size_t i = 0;
+        while ((i < sim.detections.size()) && (matched[i] ||
+                ((int32_t)(sim.detections[i].time - object.time) < 0) ||
+                ((sim.detections[i].time - object.time) > REPLAY_LATE_MS)))
+            i++;
+
+        if (i == sim.detections.size())
+        {
+            printf("  object at %u ms missed\n", object.time);
+            report.missed++;
+            continue;
+        }
+
+        matched[i] = true;
+        const t_Color & color = sim.detections[i].record.color;
+        report.colors.push_back(color);
+        if ((abs(color.red - object.red) > REPLAY_COLOR_TOLERANCE) ||
+                (abs(color.green - object.green) > REPLAY_COLOR_TOLERANCE) ||
+                (abs(color.blue - object.blue) > REPLAY_COLOR_TOLERANCE))
+        {
+            printf("  object at %u ms reported (%u,%u,%u), expected (%u,%u,%u)\n", object.time,
+                    color.red, color.green, color.blue, object.red, object.green, object.blue);
+            report.wrongColor++;
+        }
+
+        uint32_t latency = sim.detections[i].time - object.time;
+        latencySum += latency;
+        detected++;
+        if (latency > report.latencyMax)
+            report.latencyMax = latency;
+    }
+
+    for (size_t i = 0; i < matched.size(); i++)
+    {
+        if (!matched[i])
+        {
+            printf("  detection at %u ms of no object\n", sim.detections[i].time);
+            report.spurious++;
+        }
+    }
+
+    report.latencyMean = (detected > 0) ? (latencySum / detected) : 0;
+
+    uint32_t errors = report.missed + report.wrongColor + report.spurious;
+    printf("%s: %u objects, %u missed, %u wrong color, %u spurious, error rate %.1f %%, latency mean %u ms, max %u ms\n",
+            path, report.objects, report.missed, report.wrongColor, report.spurious,
+            (100.0 * errors) / report.objects, report.latencyMean, report.latencyMax);
+
+    return report;
+}
+
+TEST(replay_flying_belt)
+{
+    t_ReplayReport report = Replay_run("traces/flying_belt.trace");
+    CHECK_EQ(report.missed + report.wrongColor + report.spurious, 0);
+    CHECK(report.latencyMax < 700); /* Samples the whole object */
+}
+
+TEST(replay_stop_and_read_belt)
+{
+    t_ReplayReport report = Replay_run("traces/stop_and_read_belt.trace");
+    CHECK_EQ(report.missed + report.wrongColor + report.spurious, 0);
+    CHECK(report.latencyMax < 450);
+}
+
+/* Replay a trace and keep the detected colors for the parent process */
+static void Replay_saveColors(const char * path, const char * colorsPath)
+{
+    t_ReplayReport report = Replay_run(path);
+    CHECK_EQ(report.missed, 0);
+
+    FILE * file = fopen(colorsPath, "wb");
+    CHECK(file != nullptr);
+    CHECK_EQ(fwrite(report.colors.data(), sizeof(t_Color), report.colors.size(), file), report.colors.size());
+    fclose(file);
+}
+
+static std::vector<t_Color> Replay_loadColors(const char * colorsPath)
+{
+    std::vector<t_Color> colors;
+    t_Color color;
+
+    FILE * file = fopen(colorsPath, "rb");
+    CHECK(file != nullptr);
+    while (fread(&color, sizeof(color), 1, file) == 1)
+        colors.push_back(color);
+    fclose(file);
+    remove(colorsPath);
+    return colors;
+}
+
+static void Replay_saveFlying(void)
+{
+    Replay_saveColors("traces/flying_belt.trace", REPLAY_FLYING_COLORS);
+}
+
+static void Replay_saveStopAndRead(void)
+{
+    Replay_saveColors("traces/stop_and_read_belt.trace", REPLAY_STOP_AND_READ_COLORS);
+}
+
+TEST(flying_and_stop_and_read_agree)
+{
+    /* Both traces carry the same objects in the same order (record_traces.cpp),
+     * each replay starts the application from reset in its own process */
+    CHECK(HostTest_runChild(Replay_saveFlying));
+    CHECK(HostTest_runChild(Replay_saveStopAndRead));
+
+    std::vector<t_Color> flying = Replay_loadColors(REPLAY_FLYING_COLORS);
+    std::vector<t_Color> stopAndRead = Replay_loadColors(REPLAY_STOP_AND_READ_COLORS);
+    CHECK(!flying.empty());
+    CHECK_EQ(flying.size(), stopAndRead.size());
+
+    int colorDifference = 0, clearDifference = 0;
+    for (size_t i = 0; i < flying.size(); i++)
+    {
+        colorDifference = std::max(colorDifference, abs(flying[i].red - stopAndRead[i].red));
+        colorDifference = std::max(colorDifference, abs(flying[i].green - stopAndRead[i].green));
+        colorDifference = std::max(colorDifference, abs(flying[i].blue - stopAndRead[i].blue));
+        clearDifference = std::max(clearDifference, (100 * abs(flying[i].clear - stopAndRead[i].clear)) / stopAndRead[i].clear);
+    }
+
+    printf("%zu objects, largest difference between modes: color %d, clear %d %%\n",
+            flying.size(), colorDifference, clearDifference);
+    CHECK(colorDifference <= REPLAY_MODE_COLOR_TOLERANCE);
+    CHECK(clearDifference <= REPLAY_MODE_CLEAR_TOLERANCE);
+}
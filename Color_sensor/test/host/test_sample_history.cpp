@@ -0,0 +1,74 @@
+#include <stdlib.h>
+#include <algorithm>
+
+#include "SampleHistory.h"
+#include "HostTest.h"
+
+/* Samples added per window size, many times the largest window */
+#define HISTORY_SAMPLES 20000
+
+/* Median of the last window samples by sorting a copy, lower middle as SampleHistory_median() */
+static uint16_t History_referenceMedian(const uint16_t * samples, uint32_t added, uint8_t window)
+{
+    uint32_t count = std::min<uint32_t>(added, window);
+    uint16_t sorted[SAMPLE_HISTORY_SIZE];
+    std::copy(samples + added - count, samples + added, sorted);
+    std::sort(sorted, sorted + count);
+    return sorted[(count - 1) / 2];
+}
+
+TEST(median_matches_sorted_window)
+{
+    static uint16_t samples[HISTORY_SAMPLES];
+
+    srand(1);
+    for (uint8_t window = 1; window <= SAMPLE_HISTORY_SIZE; window++)
+    {
+        t_SampleHistory history;
+        SampleHistory_init(&history, window);
+        CHECK_EQ(SampleHistory_median(&history), 0);
+
+        uint32_t mismatches = 0;
+        for (uint32_t i = 0; i < HISTORY_SAMPLES; i++)
+        {
+            /* Narrow range in the first half, so the window often holds equal samples */
+            samples[i] = (i < (HISTORY_SAMPLES / 2)) ? (uint16_t)(rand() % 4) : (uint16_t)rand();
+            SampleHistory_add(&history, samples[i]);
+            if (SampleHistory_median(&history) != History_referenceMedian(samples, i + 1, window))
+                mismatches++;
+        }
+
+        CHECK_EQ(mismatches, 0);
+        CHECK_EQ(history.count, window);
+        CHECK(std::is_sorted(history.sorted, history.sorted + history.count));
+    }
+}
+
+TEST(outliers_are_rejected_and_evicted)
+{
+    t_SampleHistory history;
+    SampleHistory_init(&history, 3);
+
+    SampleHistory_add(&history, 100);
+    SampleHistory_add(&history, 65535);
+    CHECK_EQ(SampleHistory_median(&history), 100); /* Lower middle of two */
+    SampleHistory_add(&history, 101);
+    CHECK_EQ(SampleHistory_median(&history), 101);
+
+    /* Two more samples push the outlier out of the window */
+    SampleHistory_add(&history, 0);
+    SampleHistory_add(&history, 102);
+    CHECK_EQ(SampleHistory_median(&history), 101);
+    SampleHistory_add(&history, 103);
+    CHECK_EQ(SampleHistory_median(&history), 102);
+}
+
+TEST(window_out_of_range_uses_largest)
+{
+    t_SampleHistory history;
+
+    SampleHistory_init(&history, 0);
+    CHECK_EQ(history.window, SAMPLE_HISTORY_SIZE);
+    SampleHistory_init(&history, SAMPLE_HISTORY_SIZE + 1);
+    CHECK_EQ(history.window, SAMPLE_HISTORY_SIZE);
+}
@@ -0,0 +1,128 @@
+#include "FakeArduino.h"
+#include "Lib/Adafruit_TCS34725/Adafruit_TCS34725.h"
+#include "Tcs34725Sim.h"
+#include "HostTest.h"
+
+#define TCS_INT_PIN 4
+
+static volatile uint32_t Tcs_isrCount = 0;
+
+static void Tcs_isr(void)
+{
+    Tcs_isrCount++;
+}
+
+/* Driver on the device model, interrupt window armed around a dim scene */
+static void Tcs_setUp(Tcs34725Sim & device, Adafruit_TCS34725 & driver, const double * clear)
+{
+    Fake_reset();
+    device.setLight([clear](uint64_t) { return t_SimLight{*clear, *clear * 0.3, *clear * 0.3, *clear * 0.3}; });
+    FakeI2C_attach(TCS34725_ADDRESS, &device);
+    Fake_setTickHook([&device](uint64_t nowUs) { device.update(nowUs); });
+
+    CHECK(driver.begin());
+    driver.setIntLimits(3600, 4400);
+    driver.write8(TCS34725_PERS, TCS34725_PERS_1_CYCLE);
+    driver.setInterrupt(true);
+    driver.clearInterrupt();
+    attachInterrupt(TCS_INT_PIN, Tcs_isr, FALLING);
+}
+
+TEST(start_conversion_keeps_interrupt_enabled)
+{
+    static double clear = 100.0; /* 4000 counts at 24 ms, 4x */
+    Tcs34725Sim device(TCS_INT_PIN);
+    Adafruit_TCS34725 driver(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_4X);
+    Tcs_setUp(device, driver, &clear);
+
+    /* Capture exposure and back, as the application does for an object */
+    driver.setIntegrationTime(TCS34725_INTEGRATIONTIME_101MS);
+    driver.startConversion();
+    CHECK(device.enableRegister() & TCS34725_ENABLE_AIEN);
+    driver.setIntegrationTime(TCS34725_INTEGRATIONTIME_24MS);
+    driver.startConversion();
+    CHECK(device.enableRegister() & TCS34725_ENABLE_AIEN);
+    CHECK_EQ(device.enableRegister() & (TCS34725_ENABLE_PON | TCS34725_ENABLE_AEN), TCS34725_ENABLE_PON | TCS34725_ENABLE_AEN);
+
+    /* In window: INT stays released */
+    delay(100);
+    CHECK(!device.interruptAsserted());
+    CHECK_EQ(Tcs_isrCount, 0);
+
+    /* Light drops out of window: INT falls within one cycle */
+    clear = 50.0;
+    delay(50);
+    CHECK(device.interruptAsserted());
+    CHECK_EQ(Tcs_isrCount, 1);
+    CHECK_EQ(Fake_getPin(TCS_INT_PIN), LOW);
+
+    /* Cleared while still out of window: raised again on the next cycle */
+    driver.clearInterrupt();
+    CHECK_EQ(Fake_getPin(TCS_INT_PIN), HIGH);
+    delay(30);
+    CHECK_EQ(Tcs_isrCount, 2);
+
+    /* Back in window */
+    clear = 100.0;
+    delay(30);
+    driver.clearInterrupt();
+    delay(100);
+    CHECK_EQ(Tcs_isrCount, 2);
+    CHECK_EQ(Fake_getPin(TCS_INT_PIN), HIGH);
+}
+
+TEST(start_conversion_discards_running_cycle)
+{
+    static double clear = 100.0;
+    Tcs34725Sim device(TCS_INT_PIN);
+    Adafruit_TCS34725 driver(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_4X);
+    Tcs_setUp(device, driver, &clear);
+
+    uint16_t r, g, b, c;
+    delay(30);
+    CHECK(driver.getRawDataAsync(&r, &g, &b, &c));
+    CHECK_NEAR(c, 4000, 100);
+
+    /* New settings: no sample until a full cycle with them completed */
+    driver.setGain(TCS34725_GAIN_1X);
+    driver.startConversion();
+    delay(20);
+    CHECK(!driver.getRawDataAsync(&r, &g, &b, &c));
+    delay(10);
+    CHECK(driver.getRawDataAsync(&r, &g, &b, &c));
+    CHECK_NEAR(c, 1000, 30);
+}
+
+TEST(samples_wait_for_init_and_are_never_read_twice)
+{
+    static double clear = 100.0;
+    Tcs34725Sim device(TCS_INT_PIN);
+    Adafruit_TCS34725 driver(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_4X);
+    Tcs_setUp(device, driver, &clear);
+
+    /* First cycle ends 2.4 ms init plus 24 ms after the restart,
+     * the bus is not polled before */
+    driver.startConversion();
+    uint32_t start = millis();
+    uint32_t statusReads = device.statusReadCount();
+    uint16_t r, g, b, c;
+    while (!driver.getRawDataAsync(&r, &g, &b, &c))
+        delay(1);
+    CHECK(millis() - start >= 27);
+    CHECK_EQ(device.statusReadCount() - statusReads, 1);
+
+    /* Polled every millisecond: each sample is a new cycle, none is missed for long */
+    uint32_t lastCycle = device.cycleCount();
+    uint32_t samples = 0;
+    for (uint32_t elapsed = 0; elapsed < 1000; elapsed++)
+    {
+        delay(1);
+        if (!driver.getRawDataAsync(&r, &g, &b, &c))
+            continue;
+
+        CHECK(device.cycleCount() > lastCycle);
+        lastCycle = device.cycleCount();
+        samples++;
+    }
+    CHECK_NEAR(samples, 1000 / 24, 2);
+}
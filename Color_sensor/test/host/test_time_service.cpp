@@ -0,0 +1,107 @@
+#include <string.h>
+
+#include "FakeArduino.h"
+#include "FakeSntp.h"
+#include "TimeService.h"
+#include "HostTest.h"
+
+/* Wall-clock time of the first SNTP update, 2023-11-14 22:13:20 UTC */
+#define TIME_FIRST_UPDATE_MS 1700000000000ULL
+
+static void Time_setUp(void)
+{
+    Fake_reset();
+    FakeSntp_reset();
+    TimeService_init();
+}
+
+static void Time_update(uint64_t epochMs)
+{
+    FakeSntp_update(epochMs);
+    TimeService_task();
+}
+
+TEST(not_synced_until_first_update)
+{
+    Time_setUp();
+
+    Fake_advance(5000000);
+    TimeService_task();
+    CHECK(!TimeService_isSynced());
+    CHECK_EQ(TimeService_nowMs(), 0);
+    CHECK_EQ(TimeService_epochMsAt(millis()), 0);
+
+    Time_update(TIME_FIRST_UPDATE_MS);
+    CHECK(TimeService_isSynced());
+    CHECK_EQ(TimeService_nowMs(), TIME_FIRST_UPDATE_MS);
+
+    /* Runs on the timer between updates, past timestamps are converted back */
+    Fake_advance(1500000);
+    CHECK_EQ(TimeService_nowMs(), TIME_FIRST_UPDATE_MS + 1500);
+    CHECK_EQ(TimeService_epochMsAt(millis() - 700), TIME_FIRST_UPDATE_MS + 800);
+}
+
+TEST(drift_measured_between_updates)
+{
+    Time_setUp();
+    Time_update(TIME_FIRST_UPDATE_MS);
+
+    /* Local timer 50 ppm slow: an hour later SNTP is 180 ms ahead */
+    Fake_advance(3600000000U);
+    Time_update(TIME_FIRST_UPDATE_MS + 3600000 + 180);
+
+    t_TimeSyncInfo info;
+    TimeService_getSyncInfo(&info);
+    CHECK(info.synced);
+    CHECK_EQ(info.syncCount, 2);
+    CHECK_EQ(info.lastSyncAge, 0);
+    CHECK_EQ(info.lastCorrection, 180);
+    CHECK_NEAR(info.drift, 50, 1);
+    CHECK_EQ(TimeService_nowMs(), TIME_FIRST_UPDATE_MS + 3600180);
+}
+
+TEST(time_never_goes_back_on_a_step)
+{
+    Time_setUp();
+    Time_update(TIME_FIRST_UPDATE_MS);
+
+    Fake_advance(10000000);
+    uint64_t last = TimeService_nowMs();
+    CHECK_EQ(last, TIME_FIRST_UPDATE_MS + 10000);
+
+    /* Server sets the clock 2 s back */
+    Time_update(TIME_FIRST_UPDATE_MS + 8000);
+
+    t_TimeSyncInfo info;
+    TimeService_getSyncInfo(&info);
+    CHECK_EQ(info.lastCorrection, -2000);
+
+    /* Held for 2 s, then running again on the new anchor */
+    uint32_t decreases = 0, held = 0;
+    for (uint32_t ms = 0; ms < 3000; ms += 10)
+    {
+        Fake_advance(10000);
+        uint64_t now = TimeService_nowMs();
+        if (now < last)
+            decreases++;
+        if (now == last)
+            held++;
+        last = now;
+    }
+
+    CHECK_EQ(decreases, 0);
+    CHECK_NEAR(held, 200, 1);
+    CHECK_EQ(last, TIME_FIRST_UPDATE_MS + 11000);
+}
+
+TEST(date_formatted_in_local_time_without_padding)
+{
+    Time_setUp();
+
+    /* 2024-01-01 20:04:05 UTC, the next day in Hanoi (GMT+7) */
+    const char * date = TimeService_formatDate(1704139445);
+    CHECK(strcmp(date, "2/1/2024 03:04:05") == 0);
+
+    /* Longest date fits */
+    CHECK(strlen(TimeService_formatDate(1702222222)) < TIME_DATE_LENGTH);
+}